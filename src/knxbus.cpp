@@ -1,207 +1,717 @@
 #include "knxbus.h"
-#include <eibclient.h>
-#include <QSocketNotifier>
-#include <QDomDocument>
-#include <QDomElement>
-#include <QEventLoop>
-#include <minizip/unzip.h>
+#include <QDateTime>
+#include <QPointer>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QtAlgorithms>
+#include "knxconnection.h"
+#include "knxdptbatch.h"
+#include "knxlogging.h"
 #include "knxobject.h"
+#include "knxstringarena.h"
 
-inline void decode_dpt1(const unsigned char *data, bool *value) {
-    *value = data[0] & 0x1;
+KnxBus::KnxBus(QObject *parent)
+    : QObject{parent}
+    , m_receiver(m_objects, m_metrics, m_readScheduler, m_readManager, m_snapshot, m_history)
+{
+    qDebug() << "KNX integration loaded";
+    QObject::connect(this, &KnxBus::knxdChanged, this, &KnxBus::_tryConnect, Qt::QueuedConnection);
+    QObject::connect(this, &KnxBus::endpointsChanged, this, &KnxBus::_tryConnect, Qt::QueuedConnection);
+    QObject::connect(&m_readManager, &KnxReadManager::sendRead, this, &KnxBus::_askRead);
+    QObject::connect(&m_readScheduler, &KnxReadScheduler::sendRead, this, &KnxBus::_requestRead);
+    QObject::connect(&m_readScheduler, &KnxReadScheduler::noResponse, this, &KnxBus::_onNoResponse);
+    QObject::connect(&m_readScheduler, &KnxReadScheduler::finished, this, &KnxBus::_onInitialized);
+    memset(m_routes, -1, sizeof(m_routes));
+
+    QObject::connect(&m_metricsTimer, &QTimer::timeout, this, &KnxBus::_aggregateMetrics);
+    m_metricsTimer.start(1000);
+}
+
+KnxBus::~KnxBus()
+{
+    _closeConnections();
+}
+
+
+QString KnxBus::knxd() const {
+    return m_knxdUrl;
+}
+
+void KnxBus::setKnxd(const QString &newKnxd) {
+    if(m_knxdUrl != newKnxd)
+    {
+        m_knxdUrl = newKnxd;
+        emit knxdChanged();
+    }
+}
+
+QVariantMap KnxBus::endpoints() const {
+    return m_endpoints;
+}
+
+void KnxBus::setEndpoints(const QVariantMap &newEndpoints) {
+    if(m_endpoints != newEndpoints)
+    {
+        m_endpoints = newEndpoints;
+        emit endpointsChanged();
+    }
+}
+
+
+quint64 KnxBus::rxTelegrams() const {
+    quint64 total = 0;
+    for(const Link &link: m_links)
+        total += link.connection->rxTelegrams();
+    return total;
+}
+
+int KnxBus::rxBatchMax() const {
+    int batch = 0;
+    for(const Link &link: m_links)
+        batch = qMax(batch, link.connection->rxBatchMax());
+    return batch;
+}
+
+double KnxBus::rxBatchAverage() const {
+    double sum = 0.0;
+    quint64 telegrams = 0;
+    for(const Link &link: m_links)
+    {
+        sum += link.connection->rxBatchAverage() * link.connection->rxTelegrams();
+        telegrams += link.connection->rxTelegrams();
+    }
+    return (telegrams > 0) ? sum / telegrams : 0.0;
+}
+
+QVariantList KnxBus::rxLatencyHistogram() const {
+    QVariantList histogram;
+    for(quint64 count: m_rxLatency)
+        histogram.append(count);
+    return histogram;
+}
+
+
+int KnxBus::readRate() const {
+    return m_readScheduler.rate();
+}
+
+void KnxBus::setReadRate(int newReadRate) {
+    if(m_readScheduler.rate() != newReadRate)
+    {
+        m_readScheduler.setRate(newReadRate);
+        emit readRateChanged();
+    }
 }
 
-inline void encode_dpt1(unsigned char *data, bool value) {
-    data[0] &= 0xFE;
-    if(value) data[0] |= 0x1;
+qint64 KnxBus::initializationTime() const {
+    return m_readScheduler.duration();
 }
 
-inline void decode_dpt2(const unsigned char *data, bool *control, bool *value) {
-    *value = data[0] & 0x1;
-    *control = data[0] & 0x2;
+
+int KnxBus::readCooldown() const {
+    return m_readManager.cooldown();
 }
 
-inline void encode_dpt2(unsigned char *data, bool control, bool value) {
-    data[0] &= 0xFC;
-    if(value) data[0] |= 0x1;
-    if(control) data[0] |= 0x2;
+void KnxBus::setReadCooldown(int newReadCooldown) {
+    if(m_readManager.cooldown() != newReadCooldown)
+    {
+        m_readManager.setCooldown(newReadCooldown);
+        emit readCooldownChanged();
+    }
 }
 
-inline void decode_dpt3(const unsigned char *data, bool *control, unsigned char *stepcode) {
-    *stepcode = data[0] & 0x7;
-    *control = data[0] & 0x8;
+quint64 KnxBus::readsRequested() const {
+    return m_readManager.requested();
 }
 
-inline void encode_dpt3(unsigned char *data, bool control, unsigned char stepcode) {
-    data[0] &= 0xF0;
-    if(control) data[0] |= 0x8;
-    data[0] |= (0x7 & stepcode);
+quint64 KnxBus::readsSent() const {
+    return m_readManager.sent();
 }
 
-inline void decode_dpt4(const unsigned char *data, char *value) {
-    *value = data[1];
+quint64 KnxBus::readsSaved() const {
+    return m_readManager.saved();
 }
 
-inline void encode_dpt4(unsigned char *data, char value) {
-    data[1] = value;
+
+quint64 KnxBus::writesConfirmed() const {
+    return m_writesConfirmed;
 }
 
-inline void decode_dpt5(const unsigned char *data, unsigned char *value) {
-    *value = data[1];
+quint64 KnxBus::writesFailed() const {
+    return m_writesFailed;
 }
 
-inline void encode_dpt5(unsigned char *data, unsigned char value) {
-    data[1] = value;
+double KnxBus::writeConfirmLatency() const {
+    return m_writeConfirmLatency;
 }
 
-inline void decode_dpt6(const unsigned char *data, signed char *value) {
-    *value = data[1];
+
+int KnxBus::txRate() const {
+    return m_txRate;
 }
 
-inline void encode_dpt6(unsigned char *data, signed char value) {
-    data[1] = value;
+void KnxBus::setTxRate(int newTxRate) {
+    newTxRate = qBound(1, newTxRate, 1000);
+    if(m_txRate != newTxRate)
+    {
+        m_txRate = newTxRate;
+        for(const Link &link: std::as_const(m_links))
+            link.connection->setTxRate(m_txRate);
+        emit txRateChanged();
+    }
 }
 
-inline void decode_dpt7(const unsigned char *data, unsigned short *value) {
-    *value = data[1] << 8 | data[2];
+int KnxBus::txQueueDepth() const {
+    int depth = 0;
+    for(const Link &link: m_links)
+        depth += link.connection->txQueueDepth();
+    return depth;
 }
 
-inline void encode_dpt7(unsigned char *data, unsigned short value) {
-    data[1] = (value >> 8) & 0xFF;
-    data[2] = value & 0xFF;
+quint64 KnxBus::txDropped() const {
+    quint64 total = 0;
+    for(const Link &link: m_links)
+        total += link.connection->txDropped();
+    return total;
 }
 
-inline void decode_dpt8(const unsigned char *data, signed short *value) {
-    *value = data[1] << 8 | data[2];
+quint64 KnxBus::txCoalesced() const {
+    quint64 total = 0;
+    for(const Link &link: m_links)
+        total += link.connection->txCoalesced();
+    return total;
 }
 
-inline void encode_dpt8(unsigned char *data, signed short value) {
-    data[1] = (value >> 8) & 0xFF;
-    data[2] = value & 0xFF;
+double KnxBus::txLatency() const {
+    double latency = 0.0;
+    for(const Link &link: m_links)
+        latency = qMax(latency, link.connection->txLatency());
+    return latency;
 }
 
-inline void decode_dpt9(const unsigned char *data, float *value) {
-    unsigned char sign = (data[1] & 0x80) >>  7;
-    unsigned short exp = (data[1] & 0x78) >> 3;
-    int mant = ((data[1] & 0x07) << 8) | data[2];
-    if(sign != 0)
-        mant = -(~(mant - 1) & 0x07ff);
+QVariantMap KnxBus::deadbands() const {
+    return m_deadbands;
+}
 
-    *value  = (1 << exp) * 0.01 * ((int)mant);
+void KnxBus::setDeadbands(const QVariantMap &newDeadbands) {
+    if(m_deadbands != newDeadbands)
+    {
+        m_deadbands = newDeadbands;
+        for(KnxObject *obj: m_objects.objects())
+            _applyFilters(obj);
+        emit deadbandsChanged();
+    }
 }
 
-inline void encode_dpt9(unsigned char *data, float value) {
-    unsigned int sign = (value < 0);
-    unsigned int exp  = 0;
-    int mant = value * 100.0;
+QVariantMap KnxBus::minIntervals() const {
+    return m_minIntervals;
+}
 
-    while(mant > 2047 || mant <= -2048 )
+void KnxBus::setMinIntervals(const QVariantMap &newMinIntervals) {
+    if(m_minIntervals != newMinIntervals)
     {
-        mant = mant >> 1;
-        ++exp;
+        m_minIntervals = newMinIntervals;
+        for(KnxObject *obj: m_objects.objects())
+            _applyFilters(obj);
+        emit minIntervalsChanged();
     }
-    mant &= 0x07ff;
+}
+
+quint64 KnxBus::updatesPropagated() const {
+    return m_receiver.propagated();
+}
+
+quint64 KnxBus::updatesSuppressed() const {
+    return m_receiver.suppressed();
+}
+
+quint64 KnxBus::updatesThrottled() const {
+    return m_receiver.throttled();
+}
 
-    data[1] = (sign << 7) | (exp << 3) | ((mant & 0x07ff) >> 8);
-    data[2] = mant & 0xFF;
+quint64 KnxBus::updatesDeferred() const {
+    return m_receiver.deferred();
 }
 
-inline void decode_dpt10(const unsigned char *data, unsigned char *day, unsigned char *hour, unsigned char *minute, unsigned char *second) {
-    *day  = ((data[1]) >>5) & 0x7;
-    *hour = (data[1] & 0x1F);
-    *minute = (data[2] & 0x3F);
-    *second = (data[3] & 0x3F);
+quint64 KnxBus::updatesUnsupported() const {
+    return m_receiver.unsupported();
 }
 
-inline void encode_dpt10(unsigned char *data, unsigned char day, unsigned char hour, unsigned char minute, unsigned char second) {
-    data[1] = ((day & 0x7) << 5) | (hour & 0x1F);
-    data[2] = minute & 0x3F;
-    data[3] = second & 0x3F;
+bool KnxBus::lazyDecode() const {
+    return m_lazyDecode;
 }
 
+void KnxBus::setLazyDecode(bool newLazyDecode) {
+    if(m_lazyDecode != newLazyDecode)
+    {
+        m_lazyDecode = newLazyDecode;
+        emit lazyDecodeChanged();
+        for(KnxObject *obj: m_objects.objects())
+            obj->setLazyDecode(m_lazyDecode);
+    }
+}
 
-inline void decode_dpt11(const unsigned char *data, unsigned char *day, unsigned char *month, unsigned char *year) {
-    *day = (data[1] & 0x3F);
-    *month = (data[2] & 0x3F);
-    *year = (data[3] & 0x7F);
+int KnxBus::observedObjects() const {
+    return m_observedObjects;
 }
 
-inline void encode_dpt11(unsigned char *data, unsigned char day, unsigned char month, unsigned char year) {
-    data[1] = day & 0x3F;
-    data[2] = month & 0x3F;
-    data[3] = year & 0x7F;
+QString KnxBus::snapshot() const {
+    return m_snapshotPath;
 }
 
+void KnxBus::setSnapshot(const QString &newSnapshot) {
+    if(m_snapshotPath != newSnapshot)
+    {
+        m_snapshotPath = newSnapshot;
+        emit snapshotChanged();
+        m_snapshot.close();
+        if(!m_snapshotPath.isEmpty() && m_snapshot.open(m_snapshotPath))
+        {
+            _restoreSnapshot();
+        }
+    }
+}
 
-inline void decode_dpt12(const unsigned char *data, unsigned int *value) {
-    *value = data[1] << 24 | data[2] << 16 | data[3] << 8 | data[4];
+int KnxBus::snapshotMaxAge() const {
+    return m_snapshotMaxAge;
 }
 
-inline void encode_dpt12(unsigned char *data, unsigned int value) {
-    data[1] = (value >> 24) & 0xFF;
-    data[2] = (value >> 16) & 0xFF;
-    data[3] = (value >>  8) & 0xFF;
-    data[4] = (value >>  0) & 0xFF;
+void KnxBus::setSnapshotMaxAge(int newSnapshotMaxAge) {
+    if(m_snapshotMaxAge != newSnapshotMaxAge)
+    {
+        m_snapshotMaxAge = newSnapshotMaxAge;
+        emit snapshotMaxAgeChanged();
+    }
 }
 
-inline void decode_dpt13(const unsigned char *data, signed int *value) {
-    *value = data[1] << 24 | data[2] << 16 | data[3] << 8 | data[4];
+QStringList KnxBus::volatileAddresses() const {
+    return m_volatileAddresses;
 }
 
-inline void encode_dpt13(unsigned char *data, signed int value) {
-    data[1] = (value >> 24) & 0xFF;
-    data[2] = (value >> 16) & 0xFF;
-    data[3] = (value >>  8) & 0xFF;
-    data[4] = (value >>  0) & 0xFF;
+void KnxBus::setVolatileAddresses(const QStringList &newVolatileAddresses) {
+    if(m_volatileAddresses != newVolatileAddresses)
+    {
+        m_volatileAddresses = newVolatileAddresses;
+        m_volatile.clear();
+        for(const QString &str: std::as_const(m_volatileAddresses))
+        {
+            int gad = strToGad(str);
+            if(gad < 0)
+                qWarning() << "Invalid volatile group address" << str;
+            else
+                m_volatile.insert(static_cast<quint16>(gad));
+        }
+        emit volatileAddressesChanged();
+    }
+}
+
+
+double KnxBus::rxTelegramRate() const {
+    return m_metrics.rxRate();
 }
 
-inline void decode_dpt14(const unsigned char *data, float *value) {
-    unsigned int rdata = ((data[1]<< 24) | (data[2]<< 16) | (data[3]<< 8) | data[4]);
-    memcpy(value, &rdata, 4);
+double KnxBus::txTelegramRate() const {
+    return m_metrics.txRate();
 }
 
-inline void encode_dpt14(unsigned char *data, float value) {
-    unsigned int rdata;
-    memcpy(&rdata, &value, 4);
+quint64 KnxBus::readTelegrams() const {
+    return m_metrics.commands(KnxMetrics::Read);
+}
 
-    data[1] = (rdata >> 24) & 0xFF;
-    data[2] = (rdata >> 16) & 0xFF;
-    data[3] = (rdata >>  8) & 0xFF;
-    data[4] = (rdata >>  0) & 0xFF;
+quint64 KnxBus::writeTelegrams() const {
+    return m_metrics.commands(KnxMetrics::Write);
 }
 
-inline void decode_dpt225(const unsigned char *data, unsigned short *time_period, unsigned char *percent) {
-    *percent = data[2];
-    *time_period = data[1] << 8 | data[2];
+quint64 KnxBus::responseTelegrams() const {
+    return m_metrics.commands(KnxMetrics::Response);
 }
 
-inline void encode_dpt225(unsigned char *data, unsigned short time_period, unsigned char percent) {
-    data[1] = (time_period & 0xFF00) >> 8;
-    data[2] = time_period & 0xFF;
-    data[3] = percent;
+quint64 KnxBus::unknownTelegrams() const {
+    return m_metrics.unknownTelegrams();
 }
 
-KnxBus::KnxBus(QObject *parent)
-    : QObject{parent}
+int KnxBus::unknownAddresses() const {
+    return m_objects.notManagedCount();
+}
+
+quint64 KnxBus::decodeErrors() const {
+    return m_metrics.decodeErrors();
+}
+
+int KnxBus::rxQueueDepth() const {
+    int depth = 0;
+    for(const Link &link: m_links)
+        depth += link.connection->rxQueueDepth();
+    return depth;
+}
+
+QVariantList KnxBus::topTalkers() const {
+    QVariantList talkers;
+    for(const KnxMetrics::Talker &talker: m_metrics.topTalkers())
+    {
+        const KnxObject *obj = m_objects.object(talker.gad);
+        talkers.append(QVariantMap {
+            {"address", gadToStr(talker.gad)},
+            {"name", obj ? obj->name() : QString()},
+            {"rate", talker.rate}
+        });
+    }
+    return talkers;
+}
+
+QString KnxBus::metricsFile() const {
+    return m_metricsFile;
+}
+
+void KnxBus::setMetricsFile(const QString &newMetricsFile) {
+    if(m_metricsFile != newMetricsFile)
+    {
+        m_metricsFile = newMetricsFile;
+        m_metricsFileFailed = false;
+        emit metricsFileChanged();
+    }
+}
+
+static inline QString promLabel(QString value)
 {
-    qDebug() << "KNX integration loaded";
-    QObject::connect(this, &KnxBus::knxdChanged, this, &KnxBus::_tryConnect, Qt::QueuedConnection);
-    QObject::connect(&m_initializer, &QTimer::timeout, this, &KnxBus::_initialize);
+    return value.replace('\\', "\\\\").replace('"', "\\\"").replace('\n', "\\n");
 }
 
+QString KnxBus::metrics() const
+{
+    QString out;
+    QTextStream stream(&out);
+    auto metric = [&stream](const char *name, const char *type, const char *help) {
+        stream << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+    };
+
+    metric("knx_link_up", "gauge", "Link to the knxd endpoint established");
+    for(const Link &link: m_links)
+        stream << "knx_link_up{link=\"" << promLabel(link.url) << "\"} " << (link.connected ? 1 : 0) << '\n';
+    metric("knx_rx_telegrams_total", "counter", "Telegrams received from the bus");
+    for(const Link &link: m_links)
+        stream << "knx_rx_telegrams_total{link=\"" << promLabel(link.url) << "\"} " << link.connection->rxTelegrams() << '\n';
+    metric("knx_tx_telegrams_total", "counter", "Telegrams sent to the bus");
+    for(const Link &link: m_links)
+        stream << "knx_tx_telegrams_total{link=\"" << promLabel(link.url) << "\"} " << link.connection->txTelegrams() << '\n';
+    metric("knx_rx_telegram_rate", "gauge", "Received telegrams per second");
+    stream << "knx_rx_telegram_rate " << m_metrics.rxRate() << '\n';
+    metric("knx_tx_telegram_rate", "gauge", "Sent telegrams per second");
+    stream << "knx_tx_telegram_rate " << m_metrics.txRate() << '\n';
+
+    metric("knx_telegrams_total", "counter", "Received telegrams by APCI command");
+    stream << "knx_telegrams_total{command=\"read\"} " << m_metrics.commands(KnxMetrics::Read) << '\n';
+    stream << "knx_telegrams_total{command=\"response\"} " << m_metrics.commands(KnxMetrics::Response) << '\n';
+    stream << "knx_telegrams_total{command=\"write\"} " << m_metrics.commands(KnxMetrics::Write) << '\n';
+    stream << "knx_telegrams_total{command=\"other\"} " << m_metrics.commands(KnxMetrics::Other) << '\n';
+
+    metric("knx_unknown_telegrams_total", "counter", "Telegrams to group addresses absent from the project");
+    stream << "knx_unknown_telegrams_total " << m_metrics.unknownTelegrams() << '\n';
+    metric("knx_unknown_addresses", "gauge", "Group addresses seen on the bus but absent from the project");
+    stream << "knx_unknown_addresses " << m_objects.notManagedCount() << '\n';
+
+    metric("knx_decode_errors_total", "counter", "Telegrams not decodable for their DPT, by main type");
+    for(int dpt = 0; dpt < 256; dpt++)
+    {
+        const quint64 errors = m_metrics.decodeErrors(static_cast<quint8>(dpt));
+        if(errors > 0)
+            stream << "knx_decode_errors_total{dpt=\"" << dpt << "\"} " << errors << '\n';
+    }
 
-QString KnxBus::knxd() const {
-    return m_knxdUrl;
+    metric("knx_rx_queue_depth", "gauge", "Telegrams waiting for the object thread");
+    stream << "knx_rx_queue_depth " << rxQueueDepth() << '\n';
+    metric("knx_rx_overflow_total", "counter", "Telegrams lost because the receive ring was full");
+    for(const Link &link: m_links)
+        stream << "knx_rx_overflow_total{link=\"" << promLabel(link.url) << "\"} " << link.connection->rxOverflow() << '\n';
+    metric("knx_tx_queue_depth", "gauge", "Frames waiting in the transmit queue");
+    stream << "knx_tx_queue_depth " << txQueueDepth() << '\n';
+    metric("knx_tx_dropped_total", "counter", "Frames dropped because the transmit queue was full");
+    stream << "knx_tx_dropped_total " << txDropped() << '\n';
+    metric("knx_tx_coalesced_total", "counter", "Writes replaced by a newer value while queued");
+    stream << "knx_tx_coalesced_total " << txCoalesced() << '\n';
+
+    metric("knx_updates_total", "counter", "Value telegrams by outcome");
+    stream << "knx_updates_total{result=\"propagated\"} " << m_receiver.propagated() << '\n';
+    stream << "knx_updates_total{result=\"suppressed\"} " << m_receiver.suppressed() << '\n';
+    stream << "knx_updates_total{result=\"throttled\"} " << m_receiver.throttled() << '\n';
+    stream << "knx_updates_total{result=\"deferred\"} " << m_receiver.deferred() << '\n';
+    stream << "knx_updates_total{result=\"unsupported\"} " << m_receiver.unsupported() << '\n';
+    metric("knx_observed_objects", "gauge", "Objects with a valueChanged observer");
+    stream << "knx_observed_objects " << m_observedObjects << '\n';
+
+    metric("knx_reads_total", "counter", "Read requests by outcome");
+    stream << "knx_reads_total{result=\"requested\"} " << readsRequested() << '\n';
+    stream << "knx_reads_total{result=\"sent\"} " << readsSent() << '\n';
+    stream << "knx_reads_total{result=\"saved\"} " << readsSaved() << '\n';
+
+    metric("knx_write_confirmations_total", "counter", "Confirmed writes by outcome");
+    stream << "knx_write_confirmations_total{result=\"confirmed\"} " << m_writesConfirmed << '\n';
+    stream << "knx_write_confirmations_total{result=\"failed\"} " << m_writesFailed << '\n';
+
+    metric("knx_rx_latency_us", "histogram", "Socket read to valueChanged latency in microseconds");
+    quint64 cumulative = 0;
+    for(int i = 0; i < KNX_LATENCY_BUCKETS; i++)
+    {
+        cumulative += m_rxLatency[i];
+        stream << "knx_rx_latency_us_bucket{le=\"" << (quint64(1) << i) << "\"} " << cumulative << '\n';
+    }
+    stream << "knx_rx_latency_us_bucket{le=\"+Inf\"} " << cumulative << '\n';
+    stream << "knx_rx_latency_us_count " << cumulative << '\n';
+
+    metric("knx_group_telegrams_total", "counter", "Telegrams received per group address");
+    for(const KnxObject *obj: m_objects.objects())
+    {
+        const quint32 total = m_metrics.total(obj->gad());
+        if(total > 0)
+            stream << "knx_group_telegrams_total{address=\"" << gadToStr(obj->gad()) << "\",name=\""
+                   << promLabel(obj->name()) << "\"} " << total << '\n';
+    }
+
+    stream.flush();
+    return out;
 }
 
-void KnxBus::setKnxd(const QString &newKnxd) {
-    if(m_knxdUrl != newKnxd)
+
+int KnxBus::historyDepth() const {
+    return m_historyDepth;
+}
+
+void KnxBus::setHistoryDepth(int newHistoryDepth) {
+    /* The history slab is allocated from a QML value */
+    if(newHistoryDepth > KNX_HISTORY_MAX_DEPTH)
     {
-        m_knxdUrl = newKnxd;
-        emit knxdChanged();
+        qCWarning(lcKnx) << "KNX history depth" << newHistoryDepth << "limited to" << KNX_HISTORY_MAX_DEPTH;
+        newHistoryDepth = KNX_HISTORY_MAX_DEPTH;
+    }
+    newHistoryDepth = qMax(0, newHistoryDepth);
+    if(m_historyDepth != newHistoryDepth)
+    {
+        m_historyDepth = newHistoryDepth;
+        emit historyDepthChanged();
+        _setupHistory();
+    }
+}
+
+/* Numeric view of a decoded value for the bucket statistics */
+static bool numericValue(const KnxValue &value, double &out)
+{
+    switch(value.kind)
+    {
+    case KnxValue::Bool: out = value.b ? 1.0 : 0.0; return true;
+    case KnxValue::Int: out = static_cast<double>(value.i); return true;
+    case KnxValue::UInt: out = static_cast<double>(value.u); return true;
+    case KnxValue::Float: out = value.f; return true;
+    default: return false;
+    }
+}
+
+QVariantList KnxBus::history(const QString &ga, qint64 from, qint64 to) const
+{
+    QVariantList out;
+    const int gad = strToGad(ga);
+    if(gad < 0 || !m_history.isRecorded(static_cast<quint16>(gad)))
+        return out;
+    const KnxDptCodec *codec = m_objects.object(static_cast<quint16>(gad))->codec();
+
+    const QList<KnxHistory::Sample> samples = m_history.range(static_cast<quint16>(gad), from, to);
+    out.reserve(samples.size());
+    for(const KnxHistory::Sample &sample: samples)
+    {
+        unsigned char data[1 + KnxHistory::MaxPayload];
+        KnxValue value;
+        m_history.payload(static_cast<quint16>(gad), sample, data);
+        codec->decode(data, value);
+        out.append(QVariantMap{
+            {"time", m_history.toMSecs(sample.time)},
+            {"value", codec->toVariant(value)}
+        });
+    }
+    return out;
+}
+
+QVariantList KnxBus::historyBuckets(const QString &ga, qint64 from, qint64 to, int buckets) const
+{
+    QVariantList out;
+    const int gad = strToGad(ga);
+    if(gad < 0 || buckets <= 0 || to <= from || !m_history.isRecorded(static_cast<quint16>(gad)))
+        return out;
+    /* The bucket table is allocated from a QML argument */
+    buckets = qMin(buckets, KNX_HISTORY_MAX_BUCKETS);
+    const KnxDptCodec *codec = m_objects.object(static_cast<quint16>(gad))->codec();
+    const double width = static_cast<double>(to - from) / buckets;
+
+    struct Bucket {
+        double min;
+        double max;
+        double sum {0.0};
+        int count {0};
+    };
+    QList<Bucket> stats(buckets);
+    const QList<KnxHistory::Sample> samples = m_history.range(static_cast<quint16>(gad), from, to);
+
+    /* Float DPTs go through the batched kernels */
+    QList<float> floats;
+    if(codec->main == 9 || codec->main == 14)
+    {
+        QByteArray payloads(samples.size() * codec->size, Qt::Uninitialized);
+        for(qsizetype i = 0; i < samples.size(); i++)
+            memcpy(payloads.data() + i * codec->size, samples[i].data, codec->size);
+        floats.resize(samples.size());
+        if(codec->main == 9)
+            knxDecodeDpt9(reinterpret_cast<const unsigned char *>(payloads.constData()), floats.data(), samples.size());
+        else
+            knxDecodeDpt14(reinterpret_cast<const unsigned char *>(payloads.constData()), floats.data(), samples.size());
+    }
+
+    for(qsizetype i = 0; i < samples.size(); i++)
+    {
+        const KnxHistory::Sample &sample = samples[i];
+        double number;
+        if(!floats.isEmpty())
+        {
+            number = floats[i];
+        }
+        else
+        {
+            unsigned char data[1 + KnxHistory::MaxPayload];
+            KnxValue value;
+            m_history.payload(static_cast<quint16>(gad), sample, data);
+            codec->decode(data, value);
+            if(!numericValue(value, number))
+                continue;
+        }
+        const int index = qBound(0, static_cast<int>((m_history.toMSecs(sample.time) - from) / width), buckets - 1);
+        Bucket &bucket = stats[index];
+        if(bucket.count == 0 || number < bucket.min)
+            bucket.min = number;
+        if(bucket.count == 0 || number > bucket.max)
+            bucket.max = number;
+        bucket.sum += number;
+        bucket.count++;
+    }
+
+    for(int i = 0; i < buckets; i++)
+    {
+        const Bucket &bucket = stats[i];
+        if(bucket.count == 0)
+            continue;
+        out.append(QVariantMap{
+            {"time", from + static_cast<qint64>(i * width)},
+            {"min", bucket.min},
+            {"max", bucket.max},
+            {"avg", bucket.sum / bucket.count},
+            {"count", bucket.count}
+        });
+    }
+    return out;
+}
+
+void KnxBus::_setupHistory()
+{
+    QList<quint16> gads;
+    QList<quint8> sizes;
+    if(m_historyDepth > 0)
+    {
+        for(const KnxObject *obj: m_objects.objects())
+        {
+            if(obj->codec() && obj->codec()->size <= KnxHistory::MaxPayload)
+            {
+                gads.append(obj->gad());
+                sizes.append(obj->codec()->size);
+            }
+        }
+    }
+    int depth = m_historyDepth;
+    const qint64 slab = static_cast<qint64>(gads.size()) * depth * static_cast<qint64>(sizeof(KnxHistory::Sample));
+    if(slab > KNX_HISTORY_MAX_MEMORY)
+    {
+        const qint64 maxDepth = KNX_HISTORY_MAX_MEMORY / (gads.size() * static_cast<qint64>(sizeof(KnxHistory::Sample)));
+        qCWarning(lcKnx) << "KNX history of" << gads.size() << "objects limited to" << maxDepth << "samples instead of"
+                         << depth << "to stay under" << KNX_HISTORY_MAX_MEMORY / (1024 * 1024) << "MiB";
+        depth = static_cast<int>(maxDepth);
+    }
+    m_history.setup(depth, gads, sizes);
+    if(m_history.count() > 0)
+    {
+        qInfo().noquote() << "KNX history of" << m_history.depth() << "samples for" << m_history.count()
+                          << "objects," << m_history.memory() / 1024 << "KiB, float decoding" << knxDptBatchKernel();
+    }
+}
+
+QString KnxBus::journal() const {
+    return m_journal;
+}
+
+void KnxBus::setJournal(const QString &newJournal) {
+    if(m_journal != newJournal)
+    {
+        m_journal = newJournal;
+        emit journalChanged();
+        _configureJournal();
     }
 }
 
+int KnxBus::journalFlushInterval() const {
+    return m_journalFlushInterval;
+}
+
+void KnxBus::setJournalFlushInterval(int newJournalFlushInterval) {
+    if(m_journalFlushInterval != newJournalFlushInterval)
+    {
+        m_journalFlushInterval = newJournalFlushInterval;
+        emit journalChanged();
+        _configureJournal();
+    }
+}
+
+int KnxBus::journalSyncInterval() const {
+    return m_journalSyncInterval;
+}
+
+void KnxBus::setJournalSyncInterval(int newJournalSyncInterval) {
+    if(m_journalSyncInterval != newJournalSyncInterval)
+    {
+        m_journalSyncInterval = newJournalSyncInterval;
+        emit journalChanged();
+        _configureJournal();
+    }
+}
+
+void KnxBus::_configureJournal()
+{
+    for(int i = 0; i < m_links.size(); i++)
+    {
+        KnxConnection *connection = m_links[i].connection;
+        const QString directory = m_journal;
+        const QString name = QStringLiteral("link%1").arg(i);
+        const int flushInterval = m_journalFlushInterval;
+        const int syncInterval = m_journalSyncInterval;
+        /* The journal belongs to the I/O thread */
+        QMetaObject::invokeMethod(connection, [=]() {
+            connection->setJournal(directory, name, flushInterval, syncInterval);
+        }, Qt::QueuedConnection);
+    }
+}
+
+bool KnxBus::connected() const {
+    return m_connected;
+}
+
+quint64 KnxBus::reconnects() const {
+    quint64 total = 0;
+    for(const Link &link: m_links)
+        total += link.connection->reconnects();
+    return total;
+}
+
+qint64 KnxBus::lastOutage() const {
+    return m_lastOutage;
+}
+
+qint64 KnxBus::lastRecovery() const {
+    return m_lastRecovery;
+}
+
 
 QString KnxBus::knxProj() const {
     return m_knxProj;
@@ -220,317 +730,554 @@ void KnxBus::_parseKnxProj() {
 #ifdef DEBUG
     qDebug() << "KNX Load" << m_knxProj;
 #endif
-    QDomDocument doc;
-    unzFile zip = unzOpen64(m_knxProj.toStdString().c_str());
-    if (zip == NULL) {
-        qWarning() << "Can't open " << m_knxProj;
+    if(!m_catalog.load(m_knxProj))
         return;
-    }
 
-    if (unzGoToFirstFile (zip) != UNZ_OK) {
-        qWarning() << "Can't open " << m_knxProj;
-        return;
+    /* Informative only: a GA no device is linked to is still read, the
+     * topology of the project may be incomplete */
+    const bool topology = m_catalog.hasTopology();
+    int unlinked = 0;
+    KnxStringArena &names = KnxStringArena::names();
+    for(int i = 0; i < m_catalog.size(); i++)
+    {
+        const KnxCatalog::Entry &entry = m_catalog.entry(i);
+        KnxObject *obj = new KnxObject(names.intern(m_catalog.name(i)), entry.gad, entry.dpt, this);
+        m_objects.insert(entry.gad, obj);
+        _applyFilters(obj);
+        m_readScheduler.enqueue(entry.gad);
+        if(topology && entry.links == 0)
+            unlinked++;
+        QObject::connect(obj, &KnxObject::askRead, this, &KnxBus::_requestRead);
+        QObject::connect(obj, &KnxObject::askWrite, this, &KnxBus::_askWrite);
+        QObject::connect(obj, &KnxObject::askConfirm, this, &KnxBus::_confirmWrite);
+        QObject::connect(obj, &KnxObject::observedChanged, this, &KnxBus::_onObservedChanged);
     }
+#ifdef DEBUG
+    qDebug() << "KNX catalog" << (m_catalog.isCached() ? "loaded from cache" : "built") << m_catalog.size() << "objects";
+#endif
+    qInfo().noquote() << "KNX project" << m_catalog.projectName() << m_catalog.installationCount() << "installations,"
+                      << m_catalog.size() << "group addresses," << unlinked << "without linked comm object";
 
-    do {
-        char *fn;
-        char *buffer;
-        unz_file_info info;
-        unzGetCurrentFileInfo (zip, &info, NULL, 0, NULL, 0, NULL, 0);
+    /* Endpoints may refer to GroupRange names */
+    _buildRoutes();
+    _setupHistory();
+    _restoreSnapshot();
+}
 
-        if (info.external_fa & (1 << 4))
-            continue;
+/* Most specific setting wins: group address "1/2/3", then DPT "9.001", then main type "9" */
+static QVariant filterSetting(const QVariantMap &settings, const KnxObject *obj)
+{
+    if(settings.isEmpty())
+        return QVariant();
+    auto it = settings.constFind(gadToStr(obj->gad()));
+    if(it != settings.constEnd())
+        return it.value();
+    it = settings.constFind(QString::asprintf("%d.%03d", (obj->dpt() >> 8) & 0xFF, obj->dpt() & 0xFF));
+    if(it != settings.constEnd())
+        return it.value();
+    it = settings.constFind(QString::number((obj->dpt() >> 8) & 0xFF));
+    if(it != settings.constEnd())
+        return it.value();
+    return QVariant();
+}
 
-        if (!(fn = (char *) malloc (info.size_filename + 1)))
-        {
-            qWarning() << "Can't alocate";
-            return;
-        }
+void KnxBus::_applyFilters(KnxObject *obj)
+{
+    obj->setDeadband(filterSetting(m_deadbands, obj).toDouble());
+    obj->setMinInterval(filterSetting(m_minIntervals, obj).toInt());
+    obj->setLazyDecode(m_lazyDecode);
+}
+
+bool KnxBus::_isVolatile(const KnxObject *obj) const
+{
+    switch((obj->dpt() >> 8) & 0xFF)
+    {
+    case 10: // time of day
+    case 11: // date
+    case 19: // date time
+        return true;
+    }
+    return m_volatile.contains(obj->gad());
+}
 
-        unzGetCurrentFileInfo (zip, &info, fn, info.size_filename + 1, NULL, 0, NULL, 0);
-        QString filename(fn);
-        free(fn);
+void KnxBus::_restoreSnapshot()
+{
+    if(!m_snapshot.isOpen() || m_objects.size() == 0)
+        return;
 
-        if(!filename.endsWith("/0.xml"))
+    m_snapshot.reserve(m_objects.size());
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const qint64 maxAge = static_cast<qint64>(m_snapshotMaxAge) * 1000;
+    int restored = 0;
+    int fresh = 0;
+    int corrupted = 0;
+    /* DPT 9 and DPT 14 values go through the batched float kernels */
+    struct FloatBatch {
+        QList<KnxObject *> objects;
+        QByteArray payloads;
+    } batches[2];
+    for(KnxObject *obj: m_objects.objects())
+    {
+        const KnxSnapshot::Record *rec = m_snapshot.record(obj->gad());
+        if(!rec || rec->dpt != obj->dpt())
+            continue;
+        if(rec->len < 2 || rec->len > KnxSnapshot::MaxFrameSize)
+        {
+            corrupted++;
             continue;
-
-        if (unzOpenCurrentFile (zip) != UNZ_OK) {
-            qWarning() << "Can't open" << filename;
-            return;
         }
 
-        buffer = (char *) malloc(info.uncompressed_size + 1);
-        if(!buffer)
+        const KnxDptCodec *codec = obj->codec();
+        const int batch = !codec ? -1 : (codec->main == 9) ? 0 : (codec->main == 14) ? 1 : -1;
+        /* Objects keeping their value raw until read are not decoded here */
+        const bool deferred = obj->lazyDecode() && obj->observers() == 0;
+        if(batch >= 0 && !deferred && rec->len >= knxDptFrameSize(codec))
         {
-            qWarning() << "Can't alocate";
-            return;
+            batches[batch].objects.append(obj);
+            batches[batch].payloads.append(reinterpret_cast<const char *>(rec->frame + 2), codec->size);
         }
+        else
+        {
+            unsigned char frame[KnxSnapshot::MaxFrameSize];
+            memcpy(frame, rec->frame, rec->len);
+            obj->reciveFrame(frame, rec->len);
+        }
+        restored++;
 
-        unzReadCurrentFile(zip, buffer, info.uncompressed_size + 1);
-
-        QByteArray data(buffer, info.uncompressed_size + 1);
-        doc.setContent(data);
-        free(buffer);
-        unzCloseCurrentFile (zip);
-        break;
-    } while (unzGoToNextFile (zip) == UNZ_OK);
+        /* Fresh enough values are not read again, others are refreshed in background */
+        if(now - rec->timestamp < maxAge && !_isVolatile(obj))
+        {
+            m_readScheduler.cancel(obj->gad());
+            fresh++;
+        }
+    }
 
-    // Extract the root markup
-    QDomElement knx = doc.documentElement();
-    QDomElement project = knx.firstChild().toElement();
-    while(project.isElement() && project.tagName() != "Project")
+    QList<float> floats;
+    for(int batch = 0; batch < 2; batch++)
     {
-        project = project.nextSibling().toElement();
+        const FloatBatch &pending = batches[batch];
+        const unsigned char *payloads = reinterpret_cast<const unsigned char *>(pending.payloads.constData());
+        floats.resize(pending.objects.size());
+        if(batch == 0)
+            knxDecodeDpt9(payloads, floats.data(), floats.size());
+        else
+            knxDecodeDpt14(payloads, floats.data(), floats.size());
+        for(qsizetype i = 0; i < floats.size(); i++)
+        {
+            KnxValue value;
+            value.kind = KnxValue::Float;
+            value.f = floats[i];
+            pending.objects[i]->reciveValue(value);
+        }
     }
+    qInfo().noquote() << "KNX snapshot restored" << restored << "values," << (restored - fresh) << "to refresh";
+    if(corrupted > 0)
+        qWarning().noquote() << "KNX snapshot skipped" << corrupted << "records with an invalid frame length";
+}
+
+void KnxBus::_tryConnect() {
+    _closeConnections();
 
-    QDomElement installations = project.firstChild().toElement();
-    while(installations.isElement() && installations.tagName() != "Installations")
+    QStringList urls;
+    if(!m_knxdUrl.isEmpty())
+        urls.append(m_knxdUrl);
+    for(auto it = m_endpoints.constBegin(); it != m_endpoints.constEnd(); ++it)
     {
-        installations = installations.nextSibling().toElement();
+        if(!urls.contains(it.key()))
+            urls.append(it.key());
     }
 
-    QDomElement installation = installations.firstChild().toElement();
-    while(installation.isElement() && installation.tagName() != "Installation")
+    for(const QString &url: std::as_const(urls))
     {
-        installation = installation.nextSibling().toElement();
+        Link link;
+        link.url = url;
+        link.thread = new QThread;
+        link.thread->setObjectName(QStringLiteral("KnxIO%1").arg(m_links.size()));
+        link.connection = new KnxConnection(url);
+        link.connection->setTxRate(m_txRate);
+        link.connection->moveToThread(link.thread);
+
+        /* Handlers run queued on the bus thread and may be delivered after
+         * _closeConnections() deleted the link, the QPointer tells */
+        const QPointer<KnxConnection> connection = link.connection;
+        QObject::connect(connection, &KnxConnection::telegramsReady, this, [this, connection]() {
+            if(connection)
+                _drainTelegrams(connection);
+        });
+        QObject::connect(connection, &KnxConnection::txStatsChanged, this, &KnxBus::txStatsChanged);
+        QObject::connect(connection, &KnxConnection::finished, this, [this, connection]() {
+            if(connection)
+                _onTransportFinished(connection);
+        });
+        QObject::connect(connection, &KnxConnection::reconnected, this, [this, connection](qint64 outage) {
+            if(connection)
+                _onReconnected(connection, outage);
+        });
+        QObject::connect(connection, &KnxConnection::stateChanged, this, [this, connection](KnxConnection::State state) {
+            if(connection)
+                _onConnectionStateChanged(connection, state);
+        });
+        link.thread->start();
+        QMetaObject::invokeMethod(connection, &KnxConnection::open, Qt::QueuedConnection);
+        m_links.append(link);
     }
+    _configureJournal();
+    _buildRoutes();
+}
 
-    QDomElement groupAddresses = installation.firstChild().toElement();
-    while(groupAddresses.isElement() && groupAddresses.tagName() != "GroupAddresses")
+void KnxBus::_closeConnections()
+{
+    for(const Link &link: std::as_const(m_links))
     {
-        groupAddresses = groupAddresses.nextSibling().toElement();
+        QMetaObject::invokeMethod(link.connection, &KnxConnection::close, Qt::BlockingQueuedConnection);
+        link.thread->quit();
+        link.thread->wait();
+        delete link.connection;
+        delete link.thread;
     }
+    m_links.clear();
+    memset(m_routes, -1, sizeof(m_routes));
+    m_connected = false;
+}
 
-    QDomElement groupRanges = groupAddresses.firstChild().toElement();
-    while(groupRanges.isElement() && groupRanges.tagName() != "GroupRanges")
+void KnxBus::_buildRoutes()
+{
+    if(m_links.isEmpty())
     {
-        groupRanges = groupRanges.nextSibling().toElement();
+        memset(m_routes, -1, sizeof(m_routes));
+        return;
     }
 
-    /* Now loop on each GroupAddress */
-    QDomElement groupRange = groupRanges.firstChild().toElement();
-    while(groupRange.isElement())
-    {
-        if(groupRange.tagName() == "GroupRange")
+    /* Main group spec: number, "first-last" or GroupRange name */
+    auto route = [this](const QString &spec, qint8 index) {
+        bool ok;
+        const int main = spec.toInt(&ok);
+        if(ok && main >= 0 && main < 32)
         {
-            QString level1 = groupRange.attribute("Name");
-            QDomElement groupRange2 = groupRange.firstChild().toElement();
-            while(groupRange2.isElement())
+            m_routes[main] = index;
+            return;
+        }
+        const QStringList bounds = spec.split('-');
+        if(bounds.size() == 2)
+        {
+            bool okLast;
+            const int first = bounds[0].toInt(&ok);
+            const int last = bounds[1].toInt(&okLast);
+            if(ok && okLast && first >= 0 && first <= last && last < 32)
+            {
+                for(int i = first; i <= last; i++)
+                    m_routes[i] = index;
+                return;
+            }
+        }
+        bool found = false;
+        const QString prefix = spec + '.';
+        for(int i = 0; i < m_catalog.size(); i++)
+        {
+            const KnxCatalog::Entry &entry = m_catalog.entry(i);
+            const QString range = m_catalog.string(entry.range);
+            if(range == spec || range.startsWith(prefix))
             {
-                if(groupRange2.tagName() == "GroupRange")
-                {
-                    QString level2 = groupRange2.attribute("Name");
-                    QDomElement groupAddress = groupRange2.firstChild().toElement();
-                    while(groupAddress.isElement())
-                    {
-                        if(groupAddress.tagName() == "GroupAddress")
-                        {
-                            QString id = level1.trimmed() + "." + level2.trimmed()  + "." + groupAddress.attribute("Name").trimmed();
-                            quint16 gad = groupAddress.attribute("Address").toInt();
-                            QString dptstr = groupAddress.attribute("DatapointType");
-                            if(dptstr.isEmpty())
-                            {
-                                qWarning() << "WARNING: DPT not set for " << id;
-                            }
-                            else
-                            {
-                                quint16 dpt = _datapointTypeToDpt(dptstr);
-                                KnxObject *obj = new KnxObject(id, gad, dpt, this);
-                                m_objects[gad] = obj;
-                                m_notInitialized[gad] = 3;
-                                obj->changeValue(QVariant());
-                                QObject::connect(obj, &KnxObject::askRead, this, &KnxBus::_askRead, Qt::QueuedConnection);
-                                QObject::connect(obj, &KnxObject::askWrite, this, &KnxBus::_askWrite);
-                            }
-                        }
-                        groupAddress = groupAddress.nextSibling().toElement();
-                    }
-                }
-                groupRange2 = groupRange2.nextSibling().toElement();
+                m_routes[entry.gad >> 11] = index;
+                found = true;
             }
         }
-        groupRange = groupRange.nextSibling().toElement();
+        if(!found && m_catalog.size() > 0)
+            qWarning() << "Unknown main group or GroupRange" << spec << "in endpoints";
+    };
+
+    /* Everything else goes to the first link, knxd when set */
+    memset(m_routes, 0, sizeof(m_routes));
+    for(int index = 0; index < m_links.size(); index++)
+    {
+        const QVariant groups = m_endpoints.value(m_links[index].url);
+        if(!groups.isValid())
+            continue;
+        const QVariantList specs = (groups.typeId() == QMetaType::QVariantList) ? groups.toList() : QVariantList{groups};
+        for(const QVariant &spec: specs)
+            route(spec.toString().trimmed(), static_cast<qint8>(index));
     }
+}
 
+KnxConnection *KnxBus::_connection(quint16 gad) const
+{
+    const qint8 index = m_routes[gad >> 11];
+    return (index >= 0) ? m_links[index].connection : nullptr;
 }
 
-quint16 KnxBus::_datapointTypeToDpt(const QString &str) const
+int KnxBus::_link(const KnxConnection *connection) const
 {
-    QStringList ar(str.split("-"));
-    if(ar.size() == 2)
+    for(int i = 0; i < m_links.size(); i++)
     {
-        return ar[1].toInt() << 8;
+        if(m_links[i].connection == connection)
+            return i;
     }
-    if(ar.size() == 3)
+    return -1;
+}
+
+void KnxBus::_drainTelegrams(KnxConnection *connection)
+{
+    /* Clear the notification first, telegrams pushed meanwhile raise a new one */
+    connection->acknowledgeTelegrams();
+
+    KnxTelegram telegram;
+    int count = 0;
+    while(connection->takeTelegram(telegram))
     {
-        return ar[1].toInt() << 8 | ar[2].toInt();
+        m_receiver.handle(telegram.src, telegram.dest, telegram.frame, telegram.len);
+
+        /* Latency from socket read to valueChanged, log2 buckets of µs */
+        const quint64 us = static_cast<quint64>(knxTimestamp() - telegram.timestamp) / 1000;
+        int bucket = 0;
+        if(us > 0)
+            bucket = qMin(KNX_LATENCY_BUCKETS - 1, 64 - qCountLeadingZeroBits(us));
+        m_rxLatency[bucket]++;
+        count++;
     }
+    if(count > 0)
+        emit rxStatsChanged();
+}
+
 
-    qWarning() << "Unknown DPT " << str;
-    return 0;
+
+void KnxBus::_requestRead(quint16 gad) {
+    m_readManager.read(gad);
 }
 
-void KnxBus::_tryConnect() {
-#ifdef DEBUG
-    qInfo() << "Connect to KNXD " << m_knxdUrl.toStdString().c_str();
-#endif
-    m_knxd = EIBSocketURL(m_knxdUrl.toStdString().c_str());
-    if (EIBOpen_GroupSocket (m_knxd, 0) == -1)
-    {
-        qWarning() << "Error opening knxd socket (" << m_knxdUrl << ")";
-        exit(1);
-    }
-    m_knxdSocket = EIB_Poll_FD(m_knxd);
-    m_knxdClient = new QSocketNotifier(m_knxdSocket, QSocketNotifier::Read);
-    QObject::connect(m_knxdClient, &QSocketNotifier::activated, this, &KnxBus::_onKnxdReadyRead, Qt::QueuedConnection);
-    m_initializer.start(2000);
+void KnxBus::_askRead(quint16 gad) {
+    const unsigned char frame[2] = {
+        static_cast<unsigned char>(KNX_READ >> 2),
+        static_cast<unsigned char>((KNX_READ & 0x3) << 6)
+    };
+    if(KnxConnection *connection = _connection(gad))
+        connection->send(gad, frame, sizeof(frame), KnxTransmitQueue::Low, false);
 }
 
-void KnxBus::_onKnxdReadyRead()
-{
-    unsigned char buffer[1025];  //data buffer of 1K
-    eibaddr_t dest;
-    eibaddr_t src;
 
-    int len = EIBGetGroup_Src(m_knxd, sizeof(buffer), buffer, &src, &dest);
-    if(len < 0)
+void KnxBus::_askWrite(quint16 gad, quint16 dpt, QVariant value) {
+    if(!value.isValid())
     {
-        qWarning() << "Read EIBGetGroup_Src failed (" << len << ") try reconnection";
-        EIBClose_sync(m_knxd);
-        m_knxd = EIBSocketURL(m_knxdUrl.toStdString().c_str());
-        if (EIBOpen_GroupSocket (m_knxd, 0) == -1)
-        {
-            qWarning() << "Error opening knxd socket (" << m_knxdUrl << ")";
-            exit(1);
-        }
-        m_knxdSocket = EIB_Poll_FD(m_knxd);
-        if(m_knxdClient) m_knxdClient->deleteLater();
-        m_knxdClient = new QSocketNotifier(m_knxdSocket, QSocketNotifier::Read);
-        QObject::connect(m_knxdClient, &QSocketNotifier::activated, this, &KnxBus::_onKnxdReadyRead);
+        m_readManager.read(gad);
         return;
     }
-    if(len < 2)
+
+    KnxObject *obj = m_objects.object(gad);
+    const KnxDptCodec *codec = obj ? obj->codec() : knxDptCodec(dpt);
+    if(!codec)
     {
-        qWarning() << "Read EIBGetGroup_Src Invalid packet";
+        qDebug() << "TODO: NEED TO WRITE OBJECT " << gadToStr(gad) << " (" << dptToStr(dpt) << ")  -> " << value;
         return;
     }
-    if(m_objects.contains(dest))
-    {
-        unsigned char cmd = static_cast<unsigned char>(((buffer[0] & 0x03) << 2) | ((buffer[1] & 0xC0) >> 6));
-        if((cmd == KNX_WRITE) | (cmd == KNX_RESPONSE))
-        {
-            m_notInitialized.remove(dest);
-        }
-        m_objects[dest]->reciveFrame(buffer, len);
-    }
-    else
+
+    unsigned char frame[KNX_MAX_FRAME_SIZE] = {
+        static_cast<unsigned char>(KNX_WRITE >> 2),
+        static_cast<unsigned char>((KNX_WRITE & 0x3) << 6)
+    };
+    if(!codec->encode(value, frame + 1))
     {
-        if(!m_notmanaged.contains(dest))
-        {
-            qDebug() << "TODO: Unknown KNX Object " << gadToStr(dest);
-            m_notmanaged.append(dest);
-        }
+        qWarning() << "Can't encode" << value << "for" << gadToStr(gad) << "(" << dptToStr(dpt) << ")";
+        return;
     }
+
+    /* Switching and alarms go ahead of values */
+    KnxTransmitQueue::Lane lane = (codec->main == 1) ? KnxTransmitQueue::High : KnxTransmitQueue::Normal;
+    if(KnxConnection *connection = _connection(gad))
+        connection->send(gad, frame, knxDptFrameSize(codec), lane, true);
 }
 
+void KnxBus::_confirmWrite(quint16 gad, QVariant value)
+{
+    KnxObject *obj = m_objects.object(gad);
+    if(!obj || !obj->codec())
+        return;
 
-void KnxBus::_askRead(quint16 gad) {
-    QByteArray frame;
-    frame.append(KNX_READ >> 2);
-    frame.append((KNX_READ & 0x3) << 6);
-    if(EIBSendGroup(m_knxd, gad, frame.size(), (const uint8_t *)frame.data()) == -1)
+    WriteTransaction &transaction = m_writeTransactions[gad];
+    transaction.value = value;
+    if(!knxDptFromVariant(obj->codec(), value, transaction.expected))
     {
-        qWarning() << "EIBSendGroup error";
+        m_writeTransactions.remove(gad);
+        return;
     }
+    transaction.id = ++m_writeTransactionId;
+    transaction.attempts = 1;
+    transaction.start = knxTimestamp();
+    _readBack(gad, transaction.id);
 }
 
+/* The write is already queued before the read: lanes keep reads behind writes */
+void KnxBus::_readBack(quint16 gad, quint64 id)
+{
+    m_readManager.invalidate(gad);
+    m_readManager.read(gad, [this, gad, id](bool answered) {
+        _onReadBack(gad, id, answered);
+    });
+}
 
-void KnxBus::_askWrite(quint16 gad, quint16 dpt, QVariant value) {
-    if(!value.isValid())
+void KnxBus::_onReadBack(quint16 gad, quint64 id, bool answered)
+{
+    auto it = m_writeTransactions.find(gad);
+    if(it == m_writeTransactions.end() || it->id != id)
+        return; // Superseded by a newer write
+
+    KnxObject *obj = m_objects.object(gad);
+    if(answered && obj->latestValue() == it->expected)
     {
-        _askRead(gad);
+        const double latency = (knxTimestamp() - it->start) / 1000000.0;
+        m_writeConfirmLatency = (m_writesConfirmed == 0) ? latency : (m_writeConfirmLatency * 0.9 + latency * 0.1);
+        m_writesConfirmed++;
+        m_writeTransactions.erase(it);
+        emit writeStatsChanged();
+        emit obj->writeConfirmed(true);
         return;
     }
-    QByteArray frame;
-    frame.push_back(static_cast<char>(KNX_WRITE >> 2));
-    frame.push_back(static_cast<char>((KNX_WRITE & 0x3) << 6));
 
-    switch((dpt >> 8) & 0xFF)
-    {
-    case 1:
+    if(it->attempts >= m_writeAttempts)
     {
-        bool val = (value.toInt() == 1);
-        encode_dpt1(reinterpret_cast<unsigned char*>(frame.data() + 1), val);
-        break;
+        qWarning().noquote() << "Write not confirmed on" << gadToStr(gad) << obj->name();
+        m_writesFailed++;
+        m_writeTransactions.erase(it);
+        emit writeStatsChanged();
+        emit obj->writeConfirmed(false);
+        return;
     }
-    case 5:
+
+    it->attempts++;
+    if(answered)
     {
-        frame.push_back(static_cast<char>(0));
-        unsigned char val = 0;
-        int raw = value.toUInt();
-        switch(dpt & 0xFF)
-        {
-        case 1:
-            val = static_cast<unsigned char>((raw * 255) / 100);
-            break;
-        case 3:
-            val = static_cast<unsigned char>((raw * 255) / 360);
-            break;
-        default:
-            val = static_cast<unsigned char>(raw);
-            break;
-        }
-        encode_dpt5(reinterpret_cast<unsigned char*>(frame.data() + 1), val);
-        break;
+        /* Device answered another value: write again */
+        _askWrite(gad, obj->dpt(), it->value);
     }
-    case 9:
+    _readBack(gad, id);
+}
+
+void KnxBus::_onNoResponse(quint16 gad)
+{
+    qWarning().noquote().nospace() << "No response from " << gadToStr(gad) << " " << m_objects.object(gad)->name();
+}
+
+void KnxBus::_onInitialized(qint64 duration)
+{
+    if(m_resyncing)
     {
-        frame.push_back(static_cast<char>(0));
-        frame.push_back(static_cast<char>(0));
-        float val = value.toFloat();
-        encode_dpt9(reinterpret_cast<unsigned char*>(frame.data() + 1), val);
-        break;
+        m_resyncing = false;
+        m_lastRecovery = (knxTimestamp() - m_linkLost) / 1000000;
+        qInfo().noquote() << "KNX resync done in" << duration << "ms, recovered" << m_lastRecovery << "ms after the link loss";
+        emit connectedChanged();
+        return;
     }
-    case 20:
+    qInfo().noquote() << "KNX object model initialized in" << duration << "ms";
+    emit initializationTimeChanged();
+}
+
+void KnxBus::_onTransportFinished(KnxConnection *connection)
+{
+    /* Account the telegrams still in the ring before reporting */
+    _drainTelegrams(connection);
+
+    quint64 total = 0;
+    for(quint64 count: m_rxLatency)
+        total += count;
+    if(total == 0)
+        return;
+
+    /* Upper bound of the log2 bucket holding the given fraction of telegrams */
+    auto percentile = [this, total](double fraction) {
+        const quint64 rank = static_cast<quint64>(fraction * total);
+        quint64 seen = 0;
+        for(int i = 0; i < KNX_LATENCY_BUCKETS; i++)
+        {
+            seen += m_rxLatency[i];
+            if(seen > rank)
+                return quint64(1) << i;
+        }
+        return quint64(1) << (KNX_LATENCY_BUCKETS - 1);
+    };
+    qInfo().noquote().nospace() << "KNX latency to valueChanged: p50 < " << percentile(0.5) << " us, p99 < "
+                                << percentile(0.99) << " us, " << m_receiver.propagated() << " updates propagated";
+}
+
+void KnxBus::_aggregateMetrics()
+{
+    quint64 txTotal = 0;
+    for(const Link &link: std::as_const(m_links))
+        txTotal += link.connection->txTelegrams();
+    m_metrics.aggregate(rxTelegrams(), txTotal, knxTimestamp());
+    emit metricsChanged();
+
+    if(m_metricsFile.isEmpty())
+        return;
+    QSaveFile file(m_metricsFile);
+    file.open(QIODevice::WriteOnly | QIODevice::Text);
+    file.write(metrics().toUtf8());
+    const bool failed = !file.commit();
+    if(failed && !m_metricsFileFailed)
+        qWarning() << "Can't write metrics file" << m_metricsFile;
+    m_metricsFileFailed = failed;
+}
+
+void KnxBus::_onConnectionStateChanged(KnxConnection *connection, int state)
+{
+    const int index = _link(connection);
+    if(index < 0)
+        return;  // Closed meanwhile
+    Link &link = m_links[index];
+    const bool linkConnected = (state == KnxConnection::Connected);
+    if(linkConnected == link.connected)
+        return;
+    link.connected = linkConnected;
+    if(!linkConnected)
+        link.lost = knxTimestamp();
+
+    int up = 0;
+    for(const Link &l: std::as_const(m_links))
+        up += l.connected ? 1 : 0;
+
+    if(linkConnected && up == 1)
     {
-        frame.push_back(static_cast<char>(0));
-        unsigned char val = value.toUInt();
-        // DPT 20 is 12 Bytes; like dpt5
-        encode_dpt5(reinterpret_cast<unsigned char*>(frame.data() + 1), val);
-        break;
+        /* First connection: let knxd settle before populating the model */
+        QTimer::singleShot(m_everConnected ? 0 : 2000, &m_readScheduler, &KnxReadScheduler::start);
+        m_everConnected = true;
     }
-    default:
+    else if(up == 0)
     {
-        qDebug() << "TODO: NEED TO WRITE OBJECT " << gadToStr(gad) << " (" << dptToStr(dpt) << ")  -> " << value;
-    }
+        /* Reads would only time out, resume them once reconnected */
+        m_readScheduler.stop();
     }
 
-    if(EIBSendGroup(m_knxd, gad, frame.size(), (const uint8_t *)frame.data()) == -1)
-    {
-        qWarning() << "EIBSendGroup error";
-    }
+    m_connected = (up == m_links.size());
+    emit connectedChanged();
 }
 
-void KnxBus::_initialize()
+void KnxBus::_onReconnected(KnxConnection *connection, qint64 outage)
 {
-    QEventLoop wait;
-    QTimer timew;
-    QObject::connect(&timew, &QTimer::timeout, &wait, &QEventLoop::quit);
-    QList<uint16_t> gads = m_notInitialized.keys();
-    for(const uint16_t &gad: std::as_const(gads))
+    const int index = _link(connection);
+    if(index < 0)
+        return;
+    m_lastOutage = outage;
+    m_linkLost = m_links[index].lost;
+
+    /* Telegrams of the outage are lost: read back what may have changed on
+     * this line, values written by other devices, volatile ones and unknown ones */
+    int count = 0;
+    for(KnxObject *obj: m_objects.objects())
     {
-        if(m_notInitialized[gad]-- > 0)
-        {
-            _askRead(gad);
-            timew.start(80);
-            wait.exec();
-        }
-        else
+        const quint16 gad = obj->gad();
+        if(m_routes[gad >> 11] != index)
+            continue;
+        if(m_receiver.isSpontaneous(gad) || !obj->latestValue().isValid() || _isVolatile(obj))
         {
-            qWarning().noquote().nospace() << "No response from " << gadToStr(gad) << " " << m_objects[gad]->name();
-            m_notInitialized.remove(gad);
+            m_readScheduler.enqueue(gad);
+            count++;
         }
     }
-    if(m_notInitialized.size() == 0)
-        m_initializer.stop();
+    m_resyncing = count > 0 || m_readScheduler.pending() > 0;
+    if(!m_resyncing)
+        m_lastRecovery = (knxTimestamp() - m_linkLost) / 1000000;
+    qInfo().noquote() << "KNX link" << m_links[index].url << "back after" << outage << "ms," << count << "objects to resync";
+}
+
+void KnxBus::_onObservedChanged(bool observed)
+{
+    m_observedObjects += observed ? 1 : -1;
+    emit observedObjectsChanged();
 }
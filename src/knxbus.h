@@ -4,61 +4,344 @@
 #include <QObject>
 #include <QQmlEngine>
 #include <QTimer>
+#include <QThread>
+#include <QHash>
+#include <QSet>
 #include <cstdbool>
 #include <cstring>
+#include "knxcatalog.h"
+#include "knxdpt.h"
+#include "knxdispatchtable.h"
+#include "knxhistory.h"
+#include "knxmetrics.h"
+#include "knxreadmanager.h"
+#include "knxreadscheduler.h"
+#include "knxreceiver.h"
+#include "knxsnapshot.h"
 
 
-struct _EIBConnection;
-class QSocketNotifier;
-
+class KnxConnection;
 class KnxObject;
 
 #define KNX_READ            (0x00)
 #define KNX_RESPONSE        (0x01)
 #define KNX_WRITE           (0x02)
 
+/* log2(µs) buckets of the socket read to valueChanged latency histogram */
+#define KNX_LATENCY_BUCKETS (20)
+
+/* Upper bound of the buckets historyBuckets() splits a range in */
+#define KNX_HISTORY_MAX_BUCKETS (10000)
+
+/* Upper bound of historyDepth, a week of samples every 10 s */
+#define KNX_HISTORY_MAX_DEPTH   (65536)
+
+/* Upper bound of the history slab (8 bytes per sample), the depth is
+ * lowered so that every recorded group address fits */
+#define KNX_HISTORY_MAX_MEMORY  (256 * 1024 * 1024)
+
 class KnxBus : public QObject
 {
     Q_OBJECT
     QML_ELEMENT
 
     Q_PROPERTY(QString knxd READ knxd WRITE setKnxd NOTIFY knxdChanged FINAL)
+    Q_PROPERTY(QVariantMap endpoints READ endpoints WRITE setEndpoints NOTIFY endpointsChanged FINAL)
     Q_PROPERTY(QString knxProj READ knxProj WRITE setKnxProj NOTIFY knxProjChanged FINAL)
+    Q_PROPERTY(bool connected READ connected NOTIFY connectedChanged FINAL)
+    Q_PROPERTY(quint64 reconnects READ reconnects NOTIFY connectedChanged FINAL)
+    Q_PROPERTY(qint64 lastOutage READ lastOutage NOTIFY connectedChanged FINAL)
+    Q_PROPERTY(qint64 lastRecovery READ lastRecovery NOTIFY connectedChanged FINAL)
+    Q_PROPERTY(quint64 rxTelegrams READ rxTelegrams NOTIFY rxStatsChanged FINAL)
+    Q_PROPERTY(int rxBatchMax READ rxBatchMax NOTIFY rxStatsChanged FINAL)
+    Q_PROPERTY(double rxBatchAverage READ rxBatchAverage NOTIFY rxStatsChanged FINAL)
+    Q_PROPERTY(QVariantList rxLatencyHistogram READ rxLatencyHistogram NOTIFY rxStatsChanged FINAL)
+    Q_PROPERTY(int readRate READ readRate WRITE setReadRate NOTIFY readRateChanged FINAL)
+    Q_PROPERTY(qint64 initializationTime READ initializationTime NOTIFY initializationTimeChanged FINAL)
+    Q_PROPERTY(int readCooldown READ readCooldown WRITE setReadCooldown NOTIFY readCooldownChanged FINAL)
+    Q_PROPERTY(quint64 readsRequested READ readsRequested NOTIFY rxStatsChanged FINAL)
+    Q_PROPERTY(quint64 readsSent READ readsSent NOTIFY rxStatsChanged FINAL)
+    Q_PROPERTY(quint64 readsSaved READ readsSaved NOTIFY rxStatsChanged FINAL)
+    Q_PROPERTY(quint64 writesConfirmed READ writesConfirmed NOTIFY writeStatsChanged FINAL)
+    Q_PROPERTY(quint64 writesFailed READ writesFailed NOTIFY writeStatsChanged FINAL)
+    Q_PROPERTY(double writeConfirmLatency READ writeConfirmLatency NOTIFY writeStatsChanged FINAL)
+    Q_PROPERTY(int txRate READ txRate WRITE setTxRate NOTIFY txRateChanged FINAL)
+    Q_PROPERTY(int txQueueDepth READ txQueueDepth NOTIFY txStatsChanged FINAL)
+    Q_PROPERTY(quint64 txDropped READ txDropped NOTIFY txStatsChanged FINAL)
+    Q_PROPERTY(quint64 txCoalesced READ txCoalesced NOTIFY txStatsChanged FINAL)
+    Q_PROPERTY(double txLatency READ txLatency NOTIFY txStatsChanged FINAL)
+    Q_PROPERTY(QVariantMap deadbands READ deadbands WRITE setDeadbands NOTIFY deadbandsChanged FINAL)
+    Q_PROPERTY(QVariantMap minIntervals READ minIntervals WRITE setMinIntervals NOTIFY minIntervalsChanged FINAL)
+    Q_PROPERTY(quint64 updatesPropagated READ updatesPropagated NOTIFY rxStatsChanged FINAL)
+    Q_PROPERTY(quint64 updatesSuppressed READ updatesSuppressed NOTIFY rxStatsChanged FINAL)
+    Q_PROPERTY(quint64 updatesThrottled READ updatesThrottled NOTIFY rxStatsChanged FINAL)
+    Q_PROPERTY(quint64 updatesDeferred READ updatesDeferred NOTIFY rxStatsChanged FINAL)
+    Q_PROPERTY(quint64 updatesUnsupported READ updatesUnsupported NOTIFY rxStatsChanged FINAL)
+    Q_PROPERTY(bool lazyDecode READ lazyDecode WRITE setLazyDecode NOTIFY lazyDecodeChanged FINAL)
+    Q_PROPERTY(int observedObjects READ observedObjects NOTIFY observedObjectsChanged FINAL)
+    Q_PROPERTY(QString snapshot READ snapshot WRITE setSnapshot NOTIFY snapshotChanged FINAL)
+    Q_PROPERTY(int snapshotMaxAge READ snapshotMaxAge WRITE setSnapshotMaxAge NOTIFY snapshotMaxAgeChanged FINAL)
+    Q_PROPERTY(QStringList volatileAddresses READ volatileAddresses WRITE setVolatileAddresses NOTIFY volatileAddressesChanged FINAL)
+    Q_PROPERTY(double rxTelegramRate READ rxTelegramRate NOTIFY metricsChanged FINAL)
+    Q_PROPERTY(double txTelegramRate READ txTelegramRate NOTIFY metricsChanged FINAL)
+    Q_PROPERTY(quint64 readTelegrams READ readTelegrams NOTIFY metricsChanged FINAL)
+    Q_PROPERTY(quint64 writeTelegrams READ writeTelegrams NOTIFY metricsChanged FINAL)
+    Q_PROPERTY(quint64 responseTelegrams READ responseTelegrams NOTIFY metricsChanged FINAL)
+    Q_PROPERTY(quint64 unknownTelegrams READ unknownTelegrams NOTIFY metricsChanged FINAL)
+    Q_PROPERTY(int unknownAddresses READ unknownAddresses NOTIFY metricsChanged FINAL)
+    Q_PROPERTY(quint64 decodeErrors READ decodeErrors NOTIFY metricsChanged FINAL)
+    Q_PROPERTY(int rxQueueDepth READ rxQueueDepth NOTIFY metricsChanged FINAL)
+    Q_PROPERTY(QVariantList topTalkers READ topTalkers NOTIFY metricsChanged FINAL)
+    Q_PROPERTY(QString metricsFile READ metricsFile WRITE setMetricsFile NOTIFY metricsFileChanged FINAL)
+    Q_PROPERTY(int historyDepth READ historyDepth WRITE setHistoryDepth NOTIFY historyDepthChanged FINAL)
+    Q_PROPERTY(QString journal READ journal WRITE setJournal NOTIFY journalChanged FINAL)
+    Q_PROPERTY(int journalFlushInterval READ journalFlushInterval WRITE setJournalFlushInterval NOTIFY journalChanged FINAL)
+    Q_PROPERTY(int journalSyncInterval READ journalSyncInterval WRITE setJournalSyncInterval NOTIFY journalChanged FINAL)
 
 public:
     explicit KnxBus(QObject *parent = nullptr);
+    ~KnxBus();
 
     QString knxd() const;
     void setKnxd(const QString &newKnxd);
 
+    /* Additional knxd endpoints: url -> main groups routed to it, as a main
+     * group number, a "first-last" range, a GroupRange name of the project
+     * or a list of those. Unrouted main groups use knxd. */
+    QVariantMap endpoints() const;
+    void setEndpoints(const QVariantMap &newEndpoints);
+
     QString knxProj() const;
     void setKnxProj(const QString &newKnxProj);
 
+    bool connected() const;
+    quint64 reconnects() const;
+    /* Duration in ms of the last link outage */
+    qint64 lastOutage() const;
+    /* Time in ms from the last link loss to the end of the resync reads */
+    qint64 lastRecovery() const;
+
+    quint64 rxTelegrams() const;
+    int rxBatchMax() const;
+    double rxBatchAverage() const;
+    QVariantList rxLatencyHistogram() const;
+
+    int readRate() const;
+    void setReadRate(int newReadRate);
+
+    qint64 initializationTime() const;
+
+    int readCooldown() const;
+    void setReadCooldown(int newReadCooldown);
+
+    quint64 readsRequested() const;
+    quint64 readsSent() const;
+    quint64 readsSaved() const;
+
+    quint64 writesConfirmed() const;
+    quint64 writesFailed() const;
+    double writeConfirmLatency() const;
+
+    int txRate() const;
+    void setTxRate(int newTxRate);
+
+    int txQueueDepth() const;
+    quint64 txDropped() const;
+    quint64 txCoalesced() const;
+    double txLatency() const;
+
+    QVariantMap deadbands() const;
+    void setDeadbands(const QVariantMap &newDeadbands);
+
+    QVariantMap minIntervals() const;
+    void setMinIntervals(const QVariantMap &newMinIntervals);
+
+    quint64 updatesPropagated() const;
+    quint64 updatesSuppressed() const;
+    quint64 updatesThrottled() const;
+    quint64 updatesDeferred() const;
+    /* Value telegrams on objects with a DPT not supported, not decode errors */
+    quint64 updatesUnsupported() const;
+
+    /* Values of objects nobody observes are decoded on first access only */
+    bool lazyDecode() const;
+    void setLazyDecode(bool newLazyDecode);
+
+    /* Objects with at least one valueChanged connection or QML binding */
+    int observedObjects() const;
+
+    QString snapshot() const;
+    void setSnapshot(const QString &newSnapshot);
+
+    int snapshotMaxAge() const;
+    void setSnapshotMaxAge(int newSnapshotMaxAge);
+
+    QStringList volatileAddresses() const;
+    void setVolatileAddresses(const QStringList &newVolatileAddresses);
+
+    double rxTelegramRate() const;
+    double txTelegramRate() const;
+    quint64 readTelegrams() const;
+    quint64 writeTelegrams() const;
+    quint64 responseTelegrams() const;
+    quint64 unknownTelegrams() const;
+    int unknownAddresses() const;
+    quint64 decodeErrors() const;
+    int rxQueueDepth() const;
+    QVariantList topTalkers() const;
+
+    /* Written with every metrics period when set (node exporter textfile) */
+    QString metricsFile() const;
+    void setMetricsFile(const QString &newMetricsFile);
+
+    /* Prometheus text exposition of the bus metrics */
+    Q_INVOKABLE QString metrics() const;
+
+    /* Samples kept per group address, 0 disables the history. Limited to
+     * KNX_HISTORY_MAX_DEPTH, and to KNX_HISTORY_MAX_MEMORY for all the
+     * recorded group addresses */
+    int historyDepth() const;
+    void setHistoryDepth(int newHistoryDepth);
+
+    /* Values of a group address ("main/middle/sub") between from and to
+     * (ms since epoch), as a list of { time, value } oldest first */
+    Q_INVOKABLE QVariantList history(const QString &ga, qint64 from, qint64 to) const;
+    /* Same range split in buckets of equal duration, as a list of
+     * { time, min, max, avg, count } for the buckets holding samples.
+     * buckets is limited to KNX_HISTORY_MAX_BUCKETS, nothing is returned
+     * when it is 0 or less */
+    Q_INVOKABLE QVariantList historyBuckets(const QString &ga, qint64 from, qint64 to, int buckets) const;
+
+    /* Directory of the binary telegram journal, one segment series per link
+     * named link<n> (see KnxJournal), empty disables it. A journal segment,
+     * or the segments of one link of a directory, can be replayed with a
+     * replay: url. */
+    QString journal() const;
+    void setJournal(const QString &newJournal);
+
+    /* Longest time in ms a telegram waits in the batch before being written */
+    int journalFlushInterval() const;
+    void setJournalFlushInterval(int newJournalFlushInterval);
+
+    /* fdatasync after each batch when 0, at most every N ms when positive,
+     * never (kernel writeback) when negative */
+    int journalSyncInterval() const;
+    void setJournalSyncInterval(int newJournalSyncInterval);
 
 signals:
     void knxdChanged();
+    void endpointsChanged();
     void knxProjChanged();
+    void connectedChanged();
+    void rxStatsChanged();
+    void readRateChanged();
+    void initializationTimeChanged();
+    void readCooldownChanged();
+    void writeStatsChanged();
+    void txRateChanged();
+    void txStatsChanged();
+    void deadbandsChanged();
+    void minIntervalsChanged();
+    void snapshotChanged();
+    void snapshotMaxAgeChanged();
+    void volatileAddressesChanged();
+    void metricsChanged();
+    void metricsFileChanged();
+    void historyDepthChanged();
+    void journalChanged();
+    void lazyDecodeChanged();
+    void observedObjectsChanged();
 
 private:
     QString m_knxdUrl;
-    _EIBConnection *m_knxd {nullptr};
-    int m_knxdSocket {0};
-    QSocketNotifier *m_knxdClient {nullptr};
-    QMap<quint16, KnxObject*> m_objects;
-    QMap<quint16, quint16> m_notInitialized;
+    QVariantMap m_endpoints;
+
+    /* One knxd endpoint (TP line) with its own I/O thread and pacing */
+    struct Link {
+        QString url;
+        QThread *thread {nullptr};
+        KnxConnection *connection {nullptr};
+        bool connected {false};
+        qint64 lost {0};
+    };
+    QList<Link> m_links;
+    /* Main group to index in m_links, -1 when not routed */
+    qint8 m_routes[32];
+    bool m_connected {false};
+    bool m_everConnected {false};
+    qint64 m_linkLost {0};
+    qint64 m_lastOutage {0};
+    qint64 m_lastRecovery {0};
+    bool m_resyncing {false};
+    KnxDispatchTable m_objects;
     QString m_knxProj;
-    QList<uint16_t> m_notmanaged;
-    QTimer m_initializer;
+    KnxCatalog m_catalog;
+    KnxReadScheduler m_readScheduler;
+    KnxReadManager m_readManager;
+    int m_txRate {30};
+
+    /* Confirmed write: write, read back, compare, retry */
+    struct WriteTransaction {
+        quint64 id {0};
+        QVariant value;
+        KnxValue expected;
+        int attempts {0};
+        qint64 start {0};
+    };
+    QHash<quint16, WriteTransaction> m_writeTransactions;
+    quint64 m_writeTransactionId {0};
+    int m_writeAttempts {3};
+    quint64 m_writesConfirmed {0};
+    quint64 m_writesFailed {0};
+    double m_writeConfirmLatency {0.0};
+    QVariantMap m_deadbands;
+    QVariantMap m_minIntervals;
+    bool m_lazyDecode {false};
+    int m_observedObjects {0};
+    QString m_snapshotPath;
+    KnxSnapshot m_snapshot;
+    int m_snapshotMaxAge {3600};
+    QStringList m_volatileAddresses;
+    QSet<quint16> m_volatile;
+    quint64 m_rxLatency[KNX_LATENCY_BUCKETS] {};
+    KnxMetrics m_metrics;
+    QTimer m_metricsTimer;
+    QString m_metricsFile;
+    bool m_metricsFileFailed {false};
+    int m_historyDepth {0};
+    KnxHistory m_history;
+    KnxReceiver m_receiver;
+    QString m_journal;
+    int m_journalFlushInterval {1000};
+    int m_journalSyncInterval {0};
 
     void _parseKnxProj();
-    quint16 _datapointTypeToDpt(const QString &str) const;
+    void _applyFilters(KnxObject *obj);
+    bool _isVolatile(const KnxObject *obj) const;
+    void _restoreSnapshot();
+    void _setupHistory();
+    void _configureJournal();
+    void _closeConnections();
+    void _buildRoutes();
+    KnxConnection *_connection(quint16 gad) const;
+    int _link(const KnxConnection *connection) const;
+    void _readBack(quint16 gad, quint64 id);
+    void _onReadBack(quint16 gad, quint64 id, bool answered);
+    void _drainTelegrams(KnxConnection *connection);
+    void _onTransportFinished(KnxConnection *connection);
+    void _onConnectionStateChanged(KnxConnection *connection, int state);
+    void _onReconnected(KnxConnection *connection, qint64 outage);
 
 private slots:
     void _tryConnect();
-    void _onKnxdReadyRead();
+    void _requestRead(quint16 gad);
     void _askRead(quint16 gad);
     void _askWrite(quint16 gad, quint16 dpt, QVariant value);
-    void _initialize();
+    void _confirmWrite(quint16 gad, QVariant value);
+    void _onNoResponse(quint16 gad);
+    void _onInitialized(qint64 duration);
+    void _aggregateMetrics();
+    void _onObservedChanged(bool observed);
 };
 
 
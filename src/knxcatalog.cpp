@@ -0,0 +1,308 @@
+#include "knxcatalog.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QStringList>
+#include <cstring>
+
+#define KNX_CATALOG_VERSION     (2)
+
+/* Header flags */
+#define KNX_CATALOG_TOPOLOGY    (0x0001)
+
+static const char s_magic[4] = { 'K', 'N', 'X', 'C' };
+
+KnxCatalog::KnxCatalog()
+{
+}
+
+KnxCatalog::~KnxCatalog()
+{
+    clear();
+}
+
+bool KnxCatalog::load(const QString &project)
+{
+    clear();
+
+    QFileInfo info(project);
+    if(!info.exists())
+    {
+        qWarning() << "Can't open " << project;
+        return false;
+    }
+
+    const QString cache = cachePath(project);
+    if(_map(cache, info))
+    {
+        m_cached = true;
+        return true;
+    }
+
+    char hash[20];
+    if(!_hashProject(project, hash))
+        return false;
+
+    /* Same content with a new mtime (copy, touch): only refresh the key */
+    if(m_map && memcmp(_header()->projectHash, hash, sizeof(hash)) == 0)
+    {
+        Header *header = reinterpret_cast<Header *>(m_map);
+        header->projectMtime = info.lastModified().toMSecsSinceEpoch();
+        m_cached = true;
+        return true;
+    }
+    clear();
+
+    /* A project read with errors is used as is for this run but never
+     * cached, the next start parses it again */
+    KnxProjReader reader(project);
+    const bool complete = reader.read();
+    _build(reader, info, hash);
+    if(!complete)
+    {
+        qWarning() << reader.errorString();
+        qWarning() << "KNX catalog of" << project << "not cached";
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(cache).absolutePath());
+    QSaveFile out(cache);
+    if(out.open(QIODevice::WriteOnly))
+    {
+        out.write(m_data);
+        if(!out.commit())
+            qWarning() << "Can't write KNX catalog" << cache << out.errorString();
+    }
+    else
+    {
+        qWarning() << "Can't write KNX catalog" << cache << out.errorString();
+    }
+    return true;
+}
+
+void KnxCatalog::clear()
+{
+    if(m_map)
+    {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    if(m_file.isOpen())
+        m_file.close();
+    m_data.clear();
+    m_image = nullptr;
+    m_cached = false;
+}
+
+bool KnxCatalog::isCached() const {
+    return m_cached;
+}
+
+int KnxCatalog::size() const {
+    return m_image ? static_cast<int>(_header()->count) : 0;
+}
+
+const KnxCatalog::Entry &KnxCatalog::entry(int index) const {
+    return _entries()[index];
+}
+
+QString KnxCatalog::name(int index) const
+{
+    const Entry &e = entry(index);
+    QString range = string(e.range);
+    if(range.isEmpty())
+        return string(e.name);
+    return range + '.' + string(e.name);
+}
+
+QString KnxCatalog::string(quint32 id) const
+{
+    if(!m_image || id >= _header()->stringCount)
+        return QString();
+    const quint32 *offsets = _stringOffsets();
+    return QString::fromUtf8(_strings() + offsets[id], offsets[id + 1] - offsets[id]);
+}
+
+QString KnxCatalog::projectName() const {
+    return m_image ? string(_header()->projectName) : QString();
+}
+
+int KnxCatalog::installationCount() const {
+    return m_image ? static_cast<int>(_header()->installationCount) : 0;
+}
+
+QString KnxCatalog::installationName(int index) const {
+    return string(_installations()[index]);
+}
+
+bool KnxCatalog::hasTopology() const {
+    return m_image && (_header()->flags & KNX_CATALOG_TOPOLOGY);
+}
+
+QString KnxCatalog::cachePath(const QString &project)
+{
+    const QString absolute = QFileInfo(project).absoluteFilePath();
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if(dir.isEmpty())
+        return absolute + ".catalog";
+    const QByteArray id = QCryptographicHash::hash(absolute.toUtf8(), QCryptographicHash::Sha1).toHex().left(16);
+    return dir + "/knxcatalog-" + QString::fromLatin1(id) + ".bin";
+}
+
+quint16 KnxCatalog::datapointTypeToDpt(const QString &str)
+{
+    QStringList ar(str.split("-"));
+    if(ar.size() == 2)
+    {
+        return ar[1].toInt() << 8;
+    }
+    if(ar.size() == 3)
+    {
+        return ar[1].toInt() << 8 | ar[2].toInt();
+    }
+
+    qWarning() << "Unknown DPT " << str;
+    return 0;
+}
+
+const KnxCatalog::Header *KnxCatalog::_header() const {
+    return reinterpret_cast<const Header *>(m_image);
+}
+
+const KnxCatalog::Entry *KnxCatalog::_entries() const {
+    return reinterpret_cast<const Entry *>(m_image + sizeof(Header));
+}
+
+const quint32 *KnxCatalog::_installations() const {
+    return reinterpret_cast<const quint32 *>(m_image + sizeof(Header) + _header()->count * sizeof(Entry));
+}
+
+const quint32 *KnxCatalog::_stringOffsets() const {
+    return _installations() + _header()->installationCount;
+}
+
+const char *KnxCatalog::_strings() const {
+    return reinterpret_cast<const char *>(_stringOffsets() + _header()->stringCount + 1);
+}
+
+/* Map the cache file, return true only if its key matches the project size and mtime.
+ * A valid image with another key stays mapped so the content hash can be compared */
+bool KnxCatalog::_map(const QString &path, const QFileInfo &project)
+{
+    m_file.setFileName(path);
+    if(!m_file.open(QIODevice::ReadWrite))
+        return false;
+
+    const qint64 size = m_file.size();
+    if(size < static_cast<qint64>(sizeof(Header)))
+        return false;
+    m_map = m_file.map(0, size);
+    if(!m_map)
+        return false;
+    m_image = m_map;
+
+    const Header *header = _header();
+    const qint64 expected = static_cast<qint64>(sizeof(Header))
+                            + static_cast<qint64>(header->count) * static_cast<qint64>(sizeof(Entry))
+                            + static_cast<qint64>(header->installationCount) * static_cast<qint64>(sizeof(quint32))
+                            + (static_cast<qint64>(header->stringCount) + 1) * static_cast<qint64>(sizeof(quint32))
+                            + header->stringsSize;
+    if(memcmp(header->magic, s_magic, sizeof(s_magic)) != 0
+        || header->version != KNX_CATALOG_VERSION
+        || header->entrySize != sizeof(Entry)
+        || size != expected)
+    {
+        clear();
+        return false;
+    }
+
+    return header->projectSize == project.size()
+           && header->projectMtime == project.lastModified().toMSecsSinceEpoch();
+}
+
+bool KnxCatalog::_hashProject(const QString &project, char *hash) const
+{
+    QFile file(project);
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Can't open " << project;
+        return false;
+    }
+    QCryptographicHash sha1(QCryptographicHash::Sha1);
+    sha1.addData(&file);
+    const QByteArray result = sha1.result();
+    memcpy(hash, result.constData(), 20);
+    return true;
+}
+
+void KnxCatalog::_build(const KnxProjReader &reader, const QFileInfo &project, const char *hash)
+{
+    QList<Entry> entries;
+    QHash<QString, quint32> ids;
+    QByteArray strings;
+    QList<quint32> offsets;
+
+    auto intern = [&](const QString &str) -> quint32 {
+        auto it = ids.constFind(str);
+        if(it != ids.constEnd())
+            return it.value();
+        quint32 id = static_cast<quint32>(offsets.size());
+        offsets.append(static_cast<quint32>(strings.size()));
+        strings.append(str.toUtf8());
+        ids.insert(str, id);
+        return id;
+    };
+
+    const quint32 projectName = intern(reader.projectName());
+    QList<quint32> installations;
+    for(const QString &name: reader.installations())
+        installations.append(intern(name));
+
+    const QList<KnxProjReader::GroupAddress> &groupAddresses = reader.groupAddresses();
+    entries.reserve(groupAddresses.size());
+    for(const KnxProjReader::GroupAddress &ga: groupAddresses)
+    {
+        if(ga.datapointType.isEmpty())
+        {
+            qWarning() << "WARNING: DPT not set for " << ga.range << ga.name;
+            continue;
+        }
+        Entry e;
+        e.gad = ga.gad;
+        e.dpt = datapointTypeToDpt(ga.datapointType);
+        e.range = intern(ga.range);
+        e.name = intern(ga.name);
+        e.links = ga.links;
+        e.installation = ga.installation;
+        e.reserved = 0;
+        entries.append(e);
+    }
+    offsets.append(static_cast<quint32>(strings.size()));
+
+    Header header {};
+    memcpy(header.magic, s_magic, sizeof(s_magic));
+    header.version = KNX_CATALOG_VERSION;
+    header.entrySize = sizeof(Entry);
+    header.projectSize = project.size();
+    header.projectMtime = project.lastModified().toMSecsSinceEpoch();
+    memcpy(header.projectHash, hash, sizeof(header.projectHash));
+    header.flags = reader.hasTopology() ? KNX_CATALOG_TOPOLOGY : 0;
+    header.projectName = projectName;
+    header.installationCount = static_cast<quint32>(installations.size());
+    header.count = static_cast<quint32>(entries.size());
+    header.stringCount = static_cast<quint32>(offsets.size() - 1);
+    header.stringsSize = static_cast<quint32>(strings.size());
+
+    m_data.reserve(sizeof(Header) + entries.size() * sizeof(Entry) + (installations.size() + offsets.size()) * sizeof(quint32) + strings.size());
+    m_data.append(reinterpret_cast<const char *>(&header), sizeof(Header));
+    m_data.append(reinterpret_cast<const char *>(entries.constData()), entries.size() * sizeof(Entry));
+    m_data.append(reinterpret_cast<const char *>(installations.constData()), installations.size() * sizeof(quint32));
+    m_data.append(reinterpret_cast<const char *>(offsets.constData()), offsets.size() * sizeof(quint32));
+    m_data.append(strings);
+    m_image = reinterpret_cast<const uchar *>(m_data.constData());
+}
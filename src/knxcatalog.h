@@ -0,0 +1,93 @@
+#ifndef KNXCATALOG_H
+#define KNXCATALOG_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include "knxprojreader.h"
+
+class QFileInfo;
+
+/* Compiled group address catalog of a .knxproj.
+ *
+ * Flat binary image made of a header, a table of fixed-size entries
+ * (GA, DPT, range and name string ids, installation, comm object links),
+ * the installation name ids and an interned UTF-8 string table. The image
+ * is saved next to the cache of the application and memory-mapped on the
+ * following starts as long as the project file keeps the same size, mtime
+ * and content hash. */
+class KnxCatalog
+{
+public:
+    struct Entry {
+        quint16 gad;
+        quint16 dpt;
+        quint32 range;
+        quint32 name;
+        quint16 links;          // Comm objects linked in the topology
+        quint8 installation;
+        quint8 reserved;
+    };
+    static_assert(sizeof(Entry) == 16, "KnxCatalog::Entry must stay 16 bytes");
+
+    KnxCatalog();
+    ~KnxCatalog();
+
+    KnxCatalog(const KnxCatalog &) = delete;
+    KnxCatalog &operator=(const KnxCatalog &) = delete;
+
+    /* Map the cached catalog of project, or parse the project and rebuild the
+     * cache. A project read with errors is kept in memory only. */
+    bool load(const QString &project);
+    void clear();
+
+    bool isCached() const;
+
+    int size() const;
+    const Entry &entry(int index) const;
+    QString name(int index) const;
+    QString string(quint32 id) const;
+
+    QString projectName() const;
+    int installationCount() const;
+    QString installationName(int index) const;
+    /* True if the project topology was parsed, so Entry::links is meaningful */
+    bool hasTopology() const;
+
+    static QString cachePath(const QString &project);
+    static quint16 datapointTypeToDpt(const QString &str);
+
+private:
+    struct Header {
+        char magic[4];
+        quint16 version;
+        quint16 entrySize;
+        qint64 projectSize;
+        qint64 projectMtime;
+        char projectHash[20];
+        quint32 flags;
+        quint32 projectName;
+        quint32 installationCount;
+        quint32 count;
+        quint32 stringCount;
+        quint32 stringsSize;
+    };
+
+    QFile m_file;
+    uchar *m_map {nullptr};
+    QByteArray m_data;
+    const uchar *m_image {nullptr};
+    bool m_cached {false};
+
+    const Header *_header() const;
+    const Entry *_entries() const;
+    const quint32 *_installations() const;
+    const quint32 *_stringOffsets() const;
+    const char *_strings() const;
+
+    bool _map(const QString &path, const QFileInfo &project);
+    bool _hashProject(const QString &project, char *hash) const;
+    void _build(const KnxProjReader &reader, const QFileInfo &project, const char *hash);
+};
+
+#endif // KNXCATALOG_H
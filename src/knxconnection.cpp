@@ -0,0 +1,368 @@
+#include "knxconnection.h"
+#include "knxlogging.h"
+#include "knxtransport.h"
+#include <QSocketNotifier>
+#include <QTimer>
+#include <cstring>
+
+/* Upper bound of telegrams handled per socket wakeup, keeps the event loop responsive */
+#define KNX_RX_MAX_BATCH    (256)
+
+/* Reconnection delays in ms, doubled after each failed attempt */
+#define KNX_RECONNECT_MIN   (100)
+#define KNX_RECONNECT_MAX   (30000)
+
+KnxConnection::KnxConnection(const QString &url, QObject *parent)
+    : QObject{parent}
+    , m_url(url)
+{
+    m_sender = new QTimer(this);
+    m_sender->setTimerType(Qt::PreciseTimer);
+    m_sender->setInterval(1000 / m_txRate);
+    QObject::connect(m_sender, &QTimer::timeout, this, &KnxConnection::_flushTransmit);
+
+    m_reconnect = new QTimer(this);
+    m_reconnect->setSingleShot(true);
+    QObject::connect(m_reconnect, &QTimer::timeout, this, &KnxConnection::_reconnect);
+
+    /* Writes the journal batch of an idle link */
+    m_journalTimer = new QTimer(this);
+    QObject::connect(m_journalTimer, &QTimer::timeout, this, [this]() {
+        m_journal.flush();
+    });
+
+    /* Kept across reconnections, a replay resumes where the link was lost */
+    m_transport = KnxTransport::create(m_url, this);
+    QObject::connect(m_transport, &KnxTransport::finished, this, &KnxConnection::finished);
+}
+
+KnxConnection::~KnxConnection()
+{
+    close();
+}
+
+QString KnxConnection::url() const {
+    return m_url;
+}
+
+KnxConnection::State KnxConnection::state() const {
+    return static_cast<State>(m_state.load(std::memory_order_relaxed));
+}
+
+quint64 KnxConnection::reconnects() const {
+    return m_reconnects.load(std::memory_order_relaxed);
+}
+
+bool KnxConnection::send(quint16 gad, const unsigned char *frame, int len, KnxTransmitQueue::Lane lane, bool coalesce)
+{
+    if(len > KNX_MAX_FRAME_SIZE)
+    {
+        m_txDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    KnxTxRequest request;
+    request.timestamp = knxTimestamp();
+    request.gad = gad;
+    request.len = static_cast<quint8>(len);
+    request.lane = static_cast<quint8>(lane);
+    request.coalesce = coalesce;
+    memcpy(request.frame, frame, len);
+    if(!m_txRing.push(request))
+    {
+        m_txDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if(!m_txNotified.exchange(true, std::memory_order_acq_rel))
+        QMetaObject::invokeMethod(this, &KnxConnection::_onTxPending, Qt::QueuedConnection);
+    return true;
+}
+
+bool KnxConnection::takeTelegram(KnxTelegram &telegram) {
+    return m_rxRing.pop(telegram);
+}
+
+void KnxConnection::acknowledgeTelegrams() {
+    m_rxNotified.store(false, std::memory_order_release);
+}
+
+int KnxConnection::txRate() const {
+    return m_txRate.load(std::memory_order_relaxed);
+}
+
+void KnxConnection::setTxRate(int rate) {
+    m_txRate.store(qBound(1, rate, 1000), std::memory_order_relaxed);
+}
+
+quint64 KnxConnection::rxTelegrams() const {
+    return m_rxTelegrams.load(std::memory_order_relaxed);
+}
+
+int KnxConnection::rxBatchMax() const {
+    return m_rxBatchMax.load(std::memory_order_relaxed);
+}
+
+double KnxConnection::rxBatchAverage() const {
+    const quint64 batches = m_rxBatches.load(std::memory_order_relaxed);
+    if(batches == 0)
+        return 0.0;
+    return static_cast<double>(m_rxTelegrams.load(std::memory_order_relaxed)) / static_cast<double>(batches);
+}
+
+quint64 KnxConnection::rxOverflow() const {
+    return m_rxOverflow.load(std::memory_order_relaxed);
+}
+
+int KnxConnection::rxQueueDepth() const {
+    return static_cast<int>(m_rxRing.size());
+}
+
+quint64 KnxConnection::txTelegrams() const {
+    return m_txSent.load(std::memory_order_relaxed);
+}
+
+int KnxConnection::txQueueDepth() const {
+    return m_txQueueDepth.load(std::memory_order_relaxed);
+}
+
+quint64 KnxConnection::txDropped() const {
+    return m_txDropped.load(std::memory_order_relaxed);
+}
+
+quint64 KnxConnection::txCoalesced() const {
+    return m_txCoalesced.load(std::memory_order_relaxed);
+}
+
+double KnxConnection::txLatency() const {
+    return m_txLatency.load(std::memory_order_relaxed) / 1000000.0;
+}
+
+void KnxConnection::setJournal(const QString &directory, const QString &name, int flushInterval, int syncInterval)
+{
+    m_journal.setFlushInterval(flushInterval);
+    m_journal.setSyncInterval(syncInterval);
+    m_journalTimer->setInterval(qMax(100, m_journal.flushInterval()));
+    if(directory == m_journalDirectory && name == m_journalName)
+        return;
+
+    m_journalDirectory = directory;
+    m_journalName = name;
+    m_journalTimer->stop();
+    m_journal.close();
+    /* Otherwise opened with the link */
+    if(state() != Disconnected)
+        _openJournal();
+}
+
+void KnxConnection::open()
+{
+#ifdef DEBUG
+    qInfo() << "Connect to KNXD " << m_url.toStdString().c_str();
+#endif
+    _openJournal();
+    m_backoff = KNX_RECONNECT_MIN;
+    m_linkLost = 0;
+    _setState(Connecting);
+    _reconnect();
+}
+
+void KnxConnection::close()
+{
+    m_reconnect->stop();
+    m_sender->stop();
+    _closeLink();
+    _setState(Disconnected);
+    m_journalTimer->stop();
+    m_journal.close();
+}
+
+void KnxConnection::_closeLink()
+{
+    if(m_notifier)
+    {
+        /* May be called from the notifier's own activation */
+        m_notifier->setEnabled(false);
+        m_notifier->deleteLater();
+        m_notifier = nullptr;
+    }
+    m_transport->close();
+}
+
+bool KnxConnection::_connect()
+{
+    _closeLink();
+    if(!m_transport->open())
+    {
+        return false;
+    }
+    m_notifier = new QSocketNotifier(m_transport->fd(), QSocketNotifier::Read, this);
+    QObject::connect(m_notifier, &QSocketNotifier::activated, this, &KnxConnection::_onReadyRead);
+    return true;
+}
+
+void KnxConnection::_reconnect()
+{
+    if(state() != Connecting)
+        return;
+    if(!_connect())
+    {
+        if(m_backoff == KNX_RECONNECT_MIN)
+            qCWarning(lcKnx) << "Error opening KNX transport (" << m_url << "), retrying";
+        m_reconnect->start(m_backoff);
+        m_backoff = qMin(m_backoff * 2, KNX_RECONNECT_MAX);
+        return;
+    }
+
+    m_backoff = KNX_RECONNECT_MIN;
+    if(m_linkLost > 0)
+    {
+        const qint64 outage = (knxTimestamp() - m_linkLost) / 1000000;
+        m_linkLost = 0;
+        m_reconnects.fetch_add(1, std::memory_order_relaxed);
+        emit reconnected(outage);
+    }
+    _setState(Connected);
+    /* Frames queued during the outage */
+    _flushTransmit();
+}
+
+void KnxConnection::_linkLost()
+{
+    if(state() != Connected)
+        return;
+    _closeLink();
+    m_linkLost = knxTimestamp();
+    m_backoff = KNX_RECONNECT_MIN;
+    _setState(Connecting);
+    /* From the event loop: the caller may be iterating on the link */
+    m_reconnect->start(0);
+}
+
+void KnxConnection::_openJournal()
+{
+    if(m_journalDirectory.isEmpty() || m_journal.isOpen())
+        return;
+    if(m_journal.open(m_journalDirectory, m_journalName))
+        m_journalTimer->start();
+}
+
+void KnxConnection::_setState(State state)
+{
+    if(m_state.exchange(state, std::memory_order_relaxed) != state)
+        emit stateChanged(state);
+}
+
+void KnxConnection::_onReadyRead()
+{
+    unsigned char buffer[1025];  //data buffer of 1K
+    quint16 dest;
+    quint16 src;
+    int batch = 0;
+
+    /* Drain every complete telegram already buffered by the transport, so a
+     * burst costs one event loop round trip instead of one per telegram */
+    do
+    {
+        int len = m_transport->read(buffer, sizeof(buffer), src, dest);
+        if(len == 0)
+            break;
+        if(len < 0)
+        {
+            qCWarning(lcKnx) << "Telegram read failed (" << len << ") try reconnection";
+            _linkLost();
+            break;
+        }
+        if(len < 2)
+        {
+            qCWarning(lcKnxFrame) << "Read EIBGetGroup_Src Invalid packet";
+            continue;
+        }
+        if(len > KNX_MAX_FRAME_SIZE)
+        {
+            qCWarning(lcKnxFrame) << "Read EIBGetGroup_Src frame too long (" << len << ")";
+            continue;
+        }
+
+        KnxTelegram telegram;
+        telegram.timestamp = knxTimestamp();
+        telegram.src = src;
+        telegram.dest = dest;
+        telegram.len = static_cast<quint8>(len);
+        memcpy(telegram.frame, buffer, len);
+        m_journal.record(telegram.timestamp, src, dest, false, buffer, len);
+        if(m_rxRing.push(telegram))
+            ++batch;
+        else
+            m_rxOverflow.fetch_add(1, std::memory_order_relaxed);
+    } while(batch < KNX_RX_MAX_BATCH && m_transport->pending() > 0);
+
+    if(batch > 0)
+    {
+        m_rxBatches.fetch_add(1, std::memory_order_relaxed);
+        m_rxTelegrams.fetch_add(batch, std::memory_order_relaxed);
+        if(batch > m_rxBatchMax.load(std::memory_order_relaxed))
+            m_rxBatchMax.store(batch, std::memory_order_relaxed);
+        if(!m_rxNotified.exchange(true, std::memory_order_acq_rel))
+            emit telegramsReady();
+    }
+}
+
+void KnxConnection::_onTxPending()
+{
+    m_txNotified.store(false, std::memory_order_release);
+
+    KnxTxRequest request;
+    while(m_txRing.pop(request))
+    {
+        if(!m_txQueue.enqueue(request.gad, request.frame, request.len,
+                              static_cast<KnxTransmitQueue::Lane>(request.lane),
+                              request.coalesce, request.timestamp))
+        {
+            m_txDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    m_txCoalesced.store(m_txQueue.coalesced(), std::memory_order_relaxed);
+    _flushTransmit();
+}
+
+void KnxConnection::_flushTransmit()
+{
+    const qint64 now = knxTimestamp();
+    const int rate = m_txRate.load(std::memory_order_relaxed);
+    const double burst = qMax(1.0, rate / 4.0);
+    if(m_txLastRefill == 0)
+        m_txLastRefill = now;
+    m_txTokens = qMin(burst, m_txTokens + (now - m_txLastRefill) * rate / 1000000000.0);
+    m_txLastRefill = now;
+
+    bool sent = false;
+    const KnxTransmitQueue::Frame *frame;
+    while(state() == Connected && m_txTokens >= 1.0 && (frame = m_txQueue.front()) != nullptr)
+    {
+        if(!m_transport->send(frame->gad, frame->data, frame->len))
+        {
+            /* Keep the frame, it is sent again once reconnected */
+            qCWarning(lcKnx) << "Telegram send error";
+            _linkLost();
+            break;
+        }
+        m_journal.record(now, 0, frame->gad, true, frame->data, frame->len);
+        m_txTokens -= 1.0;
+        const qint64 latency = now - frame->enqueued;
+        const qint64 average = m_txLatency.load(std::memory_order_relaxed);
+        m_txLatency.store((m_txSent.fetch_add(1, std::memory_order_relaxed) == 0) ? latency : (average * 9 + latency) / 10, std::memory_order_relaxed);
+        m_txQueue.pop();
+        sent = true;
+    }
+    m_txQueueDepth.store(m_txQueue.size(), std::memory_order_relaxed);
+
+    m_sender->setInterval(qMax(1, 1000 / rate));
+    if(m_txQueue.isEmpty() || state() != Connected)
+        m_sender->stop();
+    else if(!m_sender->isActive())
+        m_sender->start();
+
+    if(sent)
+        emit txStatsChanged();
+}
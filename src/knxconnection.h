@@ -0,0 +1,132 @@
+#ifndef KNXCONNECTION_H
+#define KNXCONNECTION_H
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include "knxjournal.h"
+#include "knxspscring.h"
+#include "knxtelegram.h"
+#include "knxtransmitqueue.h"
+
+class KnxTransport;
+class QSocketNotifier;
+class QTimer;
+
+/* Group telegram link (knxd or replay, see KnxTransport) driven from a
+ * dedicated I/O thread.
+ *
+ * The connection is moved to its own QThread by KnxBus. Received telegrams
+ * are pushed into a lock-free SPSC ring consumed by the object thread,
+ * frames to send come through a second ring the other way and are paced
+ * by the transmit queue of the I/O thread. Methods documented as object
+ * thread side are the only ones that can be called from the KnxBus thread.
+ *
+ * A lost or refused link never stops the process: the connection goes back
+ * to Connecting and retries with an exponential backoff, frames to send
+ * stay in the transmit queue until the link is up again. */
+class KnxConnection : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State {
+        Disconnected,
+        Connecting,
+        Connected
+    };
+    Q_ENUM(State)
+
+    explicit KnxConnection(const QString &url, QObject *parent = nullptr);
+    ~KnxConnection();
+
+    QString url() const;
+
+    /* Object thread side */
+    State state() const;
+    quint64 reconnects() const;
+
+    /* Object thread side */
+    bool send(quint16 gad, const unsigned char *frame, int len, KnxTransmitQueue::Lane lane, bool coalesce);
+    bool takeTelegram(KnxTelegram &telegram);
+    void acknowledgeTelegrams();
+
+    int txRate() const;
+    void setTxRate(int rate);
+
+    quint64 rxTelegrams() const;
+    int rxBatchMax() const;
+    double rxBatchAverage() const;
+    quint64 rxOverflow() const;
+    int rxQueueDepth() const;
+
+    quint64 txTelegrams() const;
+    int txQueueDepth() const;
+    quint64 txDropped() const;
+    quint64 txCoalesced() const;
+    double txLatency() const;
+
+    /* I/O thread side: journal the telegrams of the link in directory,
+     * an empty directory stops the journal */
+    void setJournal(const QString &directory, const QString &name, int flushInterval, int syncInterval);
+
+public slots:
+    void open();
+    void close();
+
+signals:
+    void telegramsReady();
+    void txStatsChanged();
+    void finished();
+    void stateChanged(KnxConnection::State state);
+    /* Link back after an outage of the given duration in ms */
+    void reconnected(qint64 outage);
+
+private:
+    QString m_url;
+    KnxTransport *m_transport {nullptr};
+    QSocketNotifier *m_notifier {nullptr};
+    QTimer *m_sender {nullptr};
+    QTimer *m_reconnect {nullptr};
+    QTimer *m_journalTimer {nullptr};
+    KnxJournal m_journal;
+    QString m_journalDirectory;
+    QString m_journalName;
+    int m_backoff {0};
+    qint64 m_linkLost {0};
+    KnxTransmitQueue m_txQueue;
+    double m_txTokens {1.0};
+    qint64 m_txLastRefill {0};
+
+    KnxSpscRing<KnxTelegram, 1024> m_rxRing;
+    KnxSpscRing<KnxTxRequest, 256> m_txRing;
+    std::atomic<bool> m_rxNotified {false};
+    std::atomic<bool> m_txNotified {false};
+
+    std::atomic<int> m_state {Disconnected};
+    std::atomic<quint64> m_reconnects {0};
+    std::atomic<int> m_txRate {30};
+    std::atomic<quint64> m_rxTelegrams {0};
+    std::atomic<quint64> m_rxBatches {0};
+    std::atomic<int> m_rxBatchMax {0};
+    std::atomic<quint64> m_rxOverflow {0};
+    std::atomic<int> m_txQueueDepth {0};
+    std::atomic<quint64> m_txDropped {0};
+    std::atomic<quint64> m_txCoalesced {0};
+    std::atomic<quint64> m_txSent {0};
+    std::atomic<qint64> m_txLatency {0};
+
+    bool _connect();
+    void _closeLink();
+    void _linkLost();
+    void _setState(State state);
+    void _openJournal();
+
+private slots:
+    void _reconnect();
+    void _onReadyRead();
+    void _onTxPending();
+    void _flushTransmit();
+};
+
+#endif // KNXCONNECTION_H
@@ -0,0 +1,45 @@
+#include "knxdispatchtable.h"
+#include <cstring>
+
+const KnxDispatchTable::Page KnxDispatchTable::s_emptyPage {};
+
+KnxDispatchTable::KnxDispatchTable()
+{
+    for(Page *&page: m_pages)
+        page = const_cast<Page*>(&s_emptyPage);
+    memset(m_notManaged, 0, sizeof(m_notManaged));
+}
+
+KnxDispatchTable::~KnxDispatchTable()
+{
+    clear();
+}
+
+void KnxDispatchTable::insert(quint16 gad, KnxObject *obj)
+{
+    Page *&page = m_pages[gad >> 8];
+    if(page == &s_emptyPage)
+    {
+        page = new Page {};
+    }
+    KnxObject *&slot = page->objects[gad & 0xFF];
+    if(slot)
+        m_list.removeOne(slot);
+    slot = obj;
+    m_list.append(obj);
+}
+
+void KnxDispatchTable::clear()
+{
+    for(Page *&page: m_pages)
+    {
+        if(page != &s_emptyPage)
+        {
+            delete page;
+            page = const_cast<Page*>(&s_emptyPage);
+        }
+    }
+    memset(m_notManaged, 0, sizeof(m_notManaged));
+    m_notManagedCount = 0;
+    m_list.clear();
+}
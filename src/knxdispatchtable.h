@@ -0,0 +1,71 @@
+#ifndef KNXDISPATCHTABLE_H
+#define KNXDISPATCHTABLE_H
+
+#include <QList>
+#include <QtGlobal>
+
+class KnxObject;
+
+/* Group address to KnxObject lookup table.
+ *
+ * A KNX group address is 16 bits (main 5 / middle 3 / sub 8). The table is
+ * split in 256 pages indexed by main/middle, each page holding 256 object
+ * pointers indexed by sub. Unused pages point to a shared empty page so a
+ * lookup is two loads and never branches. A bitset keeps track of the
+ * addresses seen on the bus without a managed object. */
+class KnxDispatchTable
+{
+public:
+    KnxDispatchTable();
+    ~KnxDispatchTable();
+
+    KnxDispatchTable(const KnxDispatchTable &) = delete;
+    KnxDispatchTable &operator=(const KnxDispatchTable &) = delete;
+
+    inline KnxObject *object(quint16 gad) const {
+        return m_pages[gad >> 8]->objects[gad & 0xFF];
+    }
+
+    void insert(quint16 gad, KnxObject *obj);
+    void clear();
+
+    inline int size() const {
+        return m_list.size();
+    }
+
+    inline const QList<KnxObject*> &objects() const {
+        return m_list;
+    }
+
+    /* Return true the first time an address is marked */
+    inline bool markNotManaged(quint16 gad) {
+        quint64 &word = m_notManaged[gad >> 6];
+        const quint64 bit = Q_UINT64_C(1) << (gad & 0x3F);
+        const bool first = !(word & bit);
+        word |= bit;
+        m_notManagedCount += first;
+        return first;
+    }
+
+    inline bool isNotManaged(quint16 gad) const {
+        return m_notManaged[gad >> 6] & (Q_UINT64_C(1) << (gad & 0x3F));
+    }
+
+    inline int notManagedCount() const {
+        return m_notManagedCount;
+    }
+
+private:
+    struct Page {
+        KnxObject *objects[256];
+    };
+
+    static const Page s_emptyPage;
+
+    Page *m_pages[256];
+    quint64 m_notManaged[65536 / 64];
+    int m_notManagedCount {0};
+    QList<KnxObject*> m_list;
+};
+
+#endif // KNXDISPATCHTABLE_H
@@ -0,0 +1,388 @@
+#include "knxdpt.h"
+#include <QColor>
+#include <QDate>
+#include <QTime>
+#include <QVariantMap>
+
+static inline void setBool(KnxValue &value, bool b) {
+    value.kind = KnxValue::Bool;
+    value.b = b;
+}
+
+static inline void setInt(KnxValue &value, qint64 i) {
+    value.kind = KnxValue::Int;
+    value.i = i;
+}
+
+static inline void setUInt(KnxValue &value, quint64 u) {
+    value.kind = KnxValue::UInt;
+    value.u = u;
+}
+
+static inline void setFloat(KnxValue &value, double f) {
+    value.kind = KnxValue::Float;
+    value.f = f;
+}
+
+/* Keep data[1..size] as is, decoded by toVariant. data[0] only carries
+ * APCI bits for these types, it is cleared so a value read back as a
+ * response compares equal to the one written. */
+template<int Size>
+static void decodeRaw(const unsigned char *data, KnxValue &value) {
+    value.kind = KnxValue::Raw;
+    value.len = Size + 1;
+    value.raw[0] = 0;
+    memcpy(value.raw + 1, data + 1, Size);
+}
+
+static QVariant boolToVariant(const KnxValue &value) {
+    return QVariant::fromValue<bool>(value.b);
+}
+
+static QVariant intToVariant(const KnxValue &value) {
+    return QVariant::fromValue<int>(static_cast<int>(value.i));
+}
+
+static QVariant ushortToVariant(const KnxValue &value) {
+    return QVariant::fromValue<unsigned short>(static_cast<unsigned short>(value.u)); // Short instead of char to avoid toString conversion error
+}
+
+static QVariant ucharToVariant(const KnxValue &value) {
+    return QVariant::fromValue<unsigned char>(static_cast<unsigned char>(value.u));
+}
+
+static QVariant uintToVariant(const KnxValue &value) {
+    return QVariant::fromValue<unsigned int>(static_cast<unsigned int>(value.u));
+}
+
+static QVariant floatToVariant(const KnxValue &value) {
+    return QVariant::fromValue<float>(static_cast<float>(value.f));
+}
+
+/* DPT 1.xxx: boolean */
+static void decodeBool(const unsigned char *data, KnxValue &value) {
+    bool v;
+    decode_dpt1(data, &v);
+    setBool(value, v);
+}
+
+static bool encodeBool(const QVariant &value, unsigned char *data) {
+    encode_dpt1(data, value.toInt() == 1 || value.toBool());
+    return true;
+}
+
+/* DPT 2.xxx: 1 bit controlled, control << 1 | value */
+static void decodeControl(const unsigned char *data, KnxValue &value) {
+    bool control, v;
+    decode_dpt2(data, &control, &v);
+    setInt(value, (control ? 2 : 0) | (v ? 1 : 0));
+}
+
+static bool encodeControl(const QVariant &value, unsigned char *data) {
+    int raw = value.toInt();
+    encode_dpt2(data, raw & 0x2, raw & 0x1);
+    return true;
+}
+
+/* DPT 3.xxx: 3 bit controlled, signed step code (positive increases, 0 breaks) */
+static void decodeStep(const unsigned char *data, KnxValue &value) {
+    bool control;
+    unsigned char step;
+    decode_dpt3(data, &control, &step);
+    setInt(value, control ? step : -step);
+}
+
+static bool encodeStep(const QVariant &value, unsigned char *data) {
+    int raw = qBound(-7, value.toInt(), 7);
+    encode_dpt3(data, raw > 0, static_cast<unsigned char>(raw < 0 ? -raw : raw));
+    return true;
+}
+
+/* DPT 4.xxx: character */
+static QVariant charToVariant(const KnxValue &value) {
+    char c;
+    decode_dpt4(value.raw, &c);
+    return QVariant::fromValue(QString(QLatin1Char(c)));
+}
+
+static bool encodeChar(const QVariant &value, unsigned char *data) {
+    const QString str = value.toString();
+    encode_dpt4(data, str.isEmpty() ? 0 : str.at(0).toLatin1());
+    return true;
+}
+
+/* DPT 5.xxx: 8 bit unsigned, 5.001 is scaled to 0..100 % and 5.003 to 0..360 ° */
+static void decodeU8(const unsigned char *data, KnxValue &value) {
+    unsigned char v;
+    decode_dpt5(data, &v);
+    setUInt(value, v);
+}
+
+static bool encodeU8(const QVariant &value, unsigned char *data) {
+    encode_dpt5(data, static_cast<unsigned char>(value.toUInt()));
+    return true;
+}
+
+static void decodeScaling(const unsigned char *data, KnxValue &value) {
+    unsigned char v;
+    decode_dpt5(data, &v);
+    setUInt(value, (v * 100) / 255);
+}
+
+static bool encodeScaling(const QVariant &value, unsigned char *data) {
+    unsigned int raw = qMin(value.toUInt(), 100u);
+    encode_dpt5(data, static_cast<unsigned char>((raw * 255) / 100));
+    return true;
+}
+
+static void decodeAngle(const unsigned char *data, KnxValue &value) {
+    unsigned char v;
+    decode_dpt5(data, &v);
+    setUInt(value, (v * 360) / 255);
+}
+
+static bool encodeAngle(const QVariant &value, unsigned char *data) {
+    unsigned int raw = qMin(value.toUInt(), 360u);
+    encode_dpt5(data, static_cast<unsigned char>((raw * 255) / 360));
+    return true;
+}
+
+/* DPT 6.xxx: 8 bit signed */
+static void decodeS8(const unsigned char *data, KnxValue &value) {
+    signed char v;
+    decode_dpt6(data, &v);
+    setInt(value, v);
+}
+
+static bool encodeS8(const QVariant &value, unsigned char *data) {
+    encode_dpt6(data, static_cast<signed char>(qBound(-128, value.toInt(), 127)));
+    return true;
+}
+
+/* DPT 7.xxx: 16 bit unsigned */
+static void decodeU16(const unsigned char *data, KnxValue &value) {
+    unsigned short v;
+    decode_dpt7(data, &v);
+    setUInt(value, v);
+}
+
+static bool encodeU16(const QVariant &value, unsigned char *data) {
+    encode_dpt7(data, static_cast<unsigned short>(value.toUInt()));
+    return true;
+}
+
+/* DPT 8.xxx: 16 bit signed */
+static void decodeS16(const unsigned char *data, KnxValue &value) {
+    signed short v;
+    decode_dpt8(data, &v);
+    setInt(value, v);
+}
+
+static bool encodeS16(const QVariant &value, unsigned char *data) {
+    encode_dpt8(data, static_cast<signed short>(qBound(-32768, value.toInt(), 32767)));
+    return true;
+}
+
+/* DPT 9.xxx: 16 bit float */
+static void decodeFloat16(const unsigned char *data, KnxValue &value) {
+    float v;
+    decode_dpt9(data, &v);
+    setFloat(value, v);
+}
+
+static bool encodeFloat16(const QVariant &value, unsigned char *data) {
+    encode_dpt9(data, value.toFloat());
+    return true;
+}
+
+/* DPT 10.001: time of day, the week day is dropped */
+static QVariant timeToVariant(const KnxValue &value) {
+    unsigned char day, hour, minute, second;
+    decode_dpt10(value.raw, &day, &hour, &minute, &second);
+    return QVariant::fromValue(QTime(hour, minute, second));
+}
+
+static bool encodeTime(const QVariant &value, unsigned char *data) {
+    const QTime time = value.toTime();
+    if(!time.isValid())
+        return false;
+    encode_dpt10(data, 0, time.hour(), time.minute(), time.second());
+    return true;
+}
+
+/* DPT 11.001: date, years 90..99 are 1990..1999 */
+static QVariant dateToVariant(const KnxValue &value) {
+    unsigned char day, month, year;
+    decode_dpt11(value.raw, &day, &month, &year);
+    return QVariant::fromValue(QDate((year >= 90 ? 1900 : 2000) + year, month, day));
+}
+
+static bool encodeDate(const QVariant &value, unsigned char *data) {
+    const QDate date = value.toDate();
+    if(!date.isValid() || date.year() < 1990 || date.year() > 2089)
+        return false;
+    encode_dpt11(data, date.day(), date.month(), date.year() % 100);
+    return true;
+}
+
+/* DPT 12.xxx: 32 bit unsigned */
+static void decodeU32(const unsigned char *data, KnxValue &value) {
+    unsigned int v;
+    decode_dpt12(data, &v);
+    setUInt(value, v);
+}
+
+static bool encodeU32(const QVariant &value, unsigned char *data) {
+    encode_dpt12(data, value.toUInt());
+    return true;
+}
+
+/* DPT 13.xxx: 32 bit signed */
+static void decodeS32(const unsigned char *data, KnxValue &value) {
+    signed int v;
+    decode_dpt13(data, &v);
+    setInt(value, v);
+}
+
+static bool encodeS32(const QVariant &value, unsigned char *data) {
+    encode_dpt13(data, value.toInt());
+    return true;
+}
+
+/* DPT 14.xxx: 32 bit IEEE float */
+static void decodeFloat32(const unsigned char *data, KnxValue &value) {
+    float v;
+    decode_dpt14(data, &v);
+    setFloat(value, v);
+}
+
+static bool encodeFloat32(const QVariant &value, unsigned char *data) {
+    encode_dpt14(data, value.toFloat());
+    return true;
+}
+
+/* DPT 16.xxx: 14 characters string, NUL padded */
+static QVariant stringToVariant(const KnxValue &value) {
+    char str[14];
+    decode_dpt16(value.raw, str);
+    return QVariant::fromValue(QString::fromLatin1(str, qstrnlen(str, sizeof(str))));
+}
+
+static bool encodeString(const QVariant &value, unsigned char *data) {
+    char str[14] = {};
+    const QByteArray latin1 = value.toString().toLatin1();
+    memcpy(str, latin1.constData(), qMin<qsizetype>(latin1.size(), sizeof(str)));
+    encode_dpt16(data, str);
+    return true;
+}
+
+/* DPT 17.001: scene number 0..63 */
+static void decodeScene(const unsigned char *data, KnxValue &value) {
+    unsigned char scene;
+    decode_dpt17(data, &scene);
+    setUInt(value, scene);
+}
+
+static bool encodeScene(const QVariant &value, unsigned char *data) {
+    encode_dpt17(data, static_cast<unsigned char>(value.toUInt()));
+    return true;
+}
+
+/* DPT 18.001: scene control, learn flag in bit 7 as on the bus */
+static void decodeSceneControl(const unsigned char *data, KnxValue &value) {
+    bool learn;
+    unsigned char scene;
+    decode_dpt18(data, &learn, &scene);
+    setUInt(value, (learn ? 0x80 : 0x00) | scene);
+}
+
+static bool encodeSceneControl(const QVariant &value, unsigned char *data) {
+    unsigned int raw = value.toUInt();
+    encode_dpt18(data, raw & 0x80, static_cast<unsigned char>(raw));
+    return true;
+}
+
+/* DPT 225.001: scaling speed, time period and percent */
+static QVariant scalingSpeedToVariant(const KnxValue &value) {
+    unsigned short period;
+    unsigned char percent;
+    decode_dpt225(value.raw, &period, &percent);
+    QVariantMap map;
+    map["period"] = period;
+    map["percent"] = (percent * 100) / 255;
+    return map;
+}
+
+static bool encodeScalingSpeed(const QVariant &value, unsigned char *data) {
+    const QVariantMap map = value.toMap();
+    unsigned int percent = qMin(map.value("percent").toUInt(), 100u);
+    encode_dpt225(data, static_cast<unsigned short>(map.value("period").toUInt()), static_cast<unsigned char>((percent * 255) / 100));
+    return true;
+}
+
+/* DPT 232.600: RGB colour */
+static QVariant colorToVariant(const KnxValue &value) {
+    unsigned char r, g, b;
+    decode_dpt232(value.raw, &r, &g, &b);
+    return QVariant::fromValue(QColor(r, g, b));
+}
+
+static bool encodeColor(const QVariant &value, unsigned char *data) {
+    const QColor color = value.value<QColor>();
+    if(!color.isValid())
+        return false;
+    encode_dpt232(data, color.red(), color.green(), color.blue());
+    return true;
+}
+
+/* Subtype specific entries come before the generic entry of their main type */
+static constexpr KnxDptCodec s_codecs[] = {
+    {   1,  -1,  0, decodeBool,         boolToVariant,          encodeBool },
+    {   2,  -1,  0, decodeControl,      intToVariant,           encodeControl },
+    {   3,  -1,  0, decodeStep,         intToVariant,           encodeStep },
+    {   4,  -1,  1, decodeRaw<1>,       charToVariant,          encodeChar },
+    {   5,   1,  1, decodeScaling,      ushortToVariant,        encodeScaling },
+    {   5,   3,  1, decodeAngle,        ushortToVariant,        encodeAngle },
+    {   5,  -1,  1, decodeU8,           ushortToVariant,        encodeU8 },
+    {   6,  -1,  1, decodeS8,           intToVariant,           encodeS8 },
+    {   7,  -1,  2, decodeU16,          ushortToVariant,        encodeU16 },
+    {   8,  -1,  2, decodeS16,          intToVariant,           encodeS16 },
+    {   9,  -1,  2, decodeFloat16,      floatToVariant,         encodeFloat16 },
+    {  10,  -1,  3, decodeRaw<3>,       timeToVariant,          encodeTime },
+    {  11,  -1,  3, decodeRaw<3>,       dateToVariant,          encodeDate },
+    {  12,  -1,  4, decodeU32,          uintToVariant,          encodeU32 },
+    {  13,  -1,  4, decodeS32,          intToVariant,           encodeS32 },
+    {  14,  -1,  4, decodeFloat32,      floatToVariant,         encodeFloat32 },
+    {  16,  -1, 14, decodeRaw<14>,      stringToVariant,        encodeString },
+    {  17,  -1,  1, decodeScene,        uintToVariant,          encodeScene },
+    {  18,  -1,  1, decodeSceneControl, uintToVariant,          encodeSceneControl },
+    {  20,  -1,  1, decodeU8,           ucharToVariant,         encodeU8 },
+    { 225,  -1,  3, decodeRaw<3>,       scalingSpeedToVariant,  encodeScalingSpeed },
+    { 232,  -1,  3, decodeRaw<3>,       colorToVariant,         encodeColor },
+};
+
+const KnxDptCodec *knxDptCodec(quint16 dpt)
+{
+    const quint8 main = (dpt >> 8) & 0xFF;
+    const qint16 sub = dpt & 0xFF;
+    for(const KnxDptCodec &codec: s_codecs)
+    {
+        if(codec.main == main && (codec.sub < 0 || codec.sub == sub))
+            return &codec;
+    }
+    return nullptr;
+}
+
+bool knxDptFromVariant(const KnxDptCodec *codec, const QVariant &variant, KnxValue &value)
+{
+    if(!variant.isValid())
+    {
+        value = KnxValue();
+        return true;
+    }
+    unsigned char data[KNX_DPT_MAX_SIZE + 1] = {};
+    if(!codec->encode(variant, data))
+        return false;
+    codec->decode(data, value);
+    return true;
+}
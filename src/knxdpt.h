@@ -0,0 +1,321 @@
+#ifndef KNXDPT_H
+#define KNXDPT_H
+
+#include <QVariant>
+#include <QtAlgorithms>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+/* Largest DPT payload after data[0] (DPT 16) */
+#define KNX_DPT_MAX_SIZE    (14)
+
+/* Datapoint type raw helpers.
+ *
+ * data points to the first frame byte after the TPCI: data[0] holds the
+ * low bits of the APCI and the 6-bit DPTs, larger payloads start at data[1]. */
+
+static inline void decode_dpt1(const unsigned char *data, bool *value) {
+    *value = data[0] & 0x1;
+}
+
+static inline void encode_dpt1(unsigned char *data, bool value) {
+    data[0] &= 0xFE;
+    if(value) data[0] |= 0x1;
+}
+
+static inline void decode_dpt2(const unsigned char *data, bool *control, bool *value) {
+    *value = data[0] & 0x1;
+    *control = data[0] & 0x2;
+}
+
+static inline void encode_dpt2(unsigned char *data, bool control, bool value) {
+    data[0] &= 0xFC;
+    if(value) data[0] |= 0x1;
+    if(control) data[0] |= 0x2;
+}
+
+static inline void decode_dpt3(const unsigned char *data, bool *control, unsigned char *stepcode) {
+    *stepcode = data[0] & 0x7;
+    *control = data[0] & 0x8;
+}
+
+static inline void encode_dpt3(unsigned char *data, bool control, unsigned char stepcode) {
+    data[0] &= 0xF0;
+    if(control) data[0] |= 0x8;
+    data[0] |= (0x7 & stepcode);
+}
+
+static inline void decode_dpt4(const unsigned char *data, char *value) {
+    *value = data[1];
+}
+
+static inline void encode_dpt4(unsigned char *data, char value) {
+    data[1] = value;
+}
+
+static inline void decode_dpt5(const unsigned char *data, unsigned char *value) {
+    *value = data[1];
+}
+
+static inline void encode_dpt5(unsigned char *data, unsigned char value) {
+    data[1] = value;
+}
+
+static inline void decode_dpt6(const unsigned char *data, signed char *value) {
+    *value = data[1];
+}
+
+static inline void encode_dpt6(unsigned char *data, signed char value) {
+    data[1] = value;
+}
+
+static inline void decode_dpt7(const unsigned char *data, unsigned short *value) {
+    *value = data[1] << 8 | data[2];
+}
+
+static inline void encode_dpt7(unsigned char *data, unsigned short value) {
+    data[1] = (value >> 8) & 0xFF;
+    data[2] = value & 0xFF;
+}
+
+static inline void decode_dpt8(const unsigned char *data, signed short *value) {
+    *value = data[1] << 8 | data[2];
+}
+
+static inline void encode_dpt8(unsigned char *data, signed short value) {
+    data[1] = (value >> 8) & 0xFF;
+    data[2] = value & 0xFF;
+}
+
+static inline void decode_dpt9(const unsigned char *data, float *value) {
+    int raw = data[1] << 8 | data[2];
+    /* 12-bit two's complement mantissa: the sign bit weighs -2048 */
+    int mant = (raw & 0x07ff) - ((raw & 0x8000) >> 4);
+    int exp = (raw >> 11) & 0x0f;
+
+    *value  = (1 << exp) * 0.01 * mant;
+}
+
+/* Nearest DPT 9 value, ties to even mantissa, with the smallest exponent.
+ * Constant time: the exponent comes from a count of leading zeros, the
+ * rounding from the FPU. Out of range values are clamped to -671088.64 and
+ * 670760.96, NaN is encoded as 0x7FFF (invalid data). */
+static inline void encode_dpt9(unsigned char *data, float value) {
+    /* value * 100 is exact in a double */
+    const double hundredths = static_cast<double>(value) * 100.0;
+    const double x = (hundredths == hundredths) ? qBound(-2048.0 * 32768.0, hundredths, 2047.0 * 32768.0) : 2047.0 * 32768.0;
+
+    /* Smallest exp with x / 2^exp in [-2048, 2048): from floor(x) when
+     * positive, ceil(-x) - 1 when negative, i.e. floor(x) ^ sign */
+    qint64 f = static_cast<qint64>(x);
+    f -= (f > x);
+    const quint64 k = static_cast<quint64>(f ^ (f >> 63));
+    int exp = qMax(0, 64 - static_cast<int>(qCountLeadingZeroBits(k | 1)) - 11);
+
+    /* x / 2^exp is exact, round it half to even */
+    double scale;
+    const quint64 bits = static_cast<quint64>(1023 - exp) << 52;
+    memcpy(&scale, &bits, sizeof(scale));
+#if FLT_EVAL_METHOD == 0
+    int mant = static_cast<int>((x * scale + 6755399441055744.0) - 6755399441055744.0);
+#else
+    int mant = static_cast<int>(std::lrint(x * scale));
+#endif
+    /* 2047.5 and above rounds to 2048, which is 1024 at the next exponent.
+     * Down to -2048.5 rounds to -2048, found as -1024 at the next exponent */
+    const int carry = (mant >> 11) & ~(mant >> 31) & 1;
+    const int borrow = (mant == -1024) & (exp > 0);
+    exp += carry - borrow;
+    mant = (mant >> carry) - (borrow << 10);
+
+    const int raw = ((mant & 0x800) << 4) | (exp << 11) | (mant & 0x07ff);
+    data[1] = (raw >> 8) & 0xFF;
+    data[2] = raw & 0xFF;
+}
+
+static inline void decode_dpt10(const unsigned char *data, unsigned char *day, unsigned char *hour, unsigned char *minute, unsigned char *second) {
+    *day  = ((data[1]) >>5) & 0x7;
+    *hour = (data[1] & 0x1F);
+    *minute = (data[2] & 0x3F);
+    *second = (data[3] & 0x3F);
+}
+
+static inline void encode_dpt10(unsigned char *data, unsigned char day, unsigned char hour, unsigned char minute, unsigned char second) {
+    data[1] = ((day & 0x7) << 5) | (hour & 0x1F);
+    data[2] = minute & 0x3F;
+    data[3] = second & 0x3F;
+}
+
+
+static inline void decode_dpt11(const unsigned char *data, unsigned char *day, unsigned char *month, unsigned char *year) {
+    *day = (data[1] & 0x3F);
+    *month = (data[2] & 0x3F);
+    *year = (data[3] & 0x7F);
+}
+
+static inline void encode_dpt11(unsigned char *data, unsigned char day, unsigned char month, unsigned char year) {
+    data[1] = day & 0x3F;
+    data[2] = month & 0x3F;
+    data[3] = year & 0x7F;
+}
+
+
+static inline void decode_dpt12(const unsigned char *data, unsigned int *value) {
+    *value = data[1] << 24 | data[2] << 16 | data[3] << 8 | data[4];
+}
+
+static inline void encode_dpt12(unsigned char *data, unsigned int value) {
+    data[1] = (value >> 24) & 0xFF;
+    data[2] = (value >> 16) & 0xFF;
+    data[3] = (value >>  8) & 0xFF;
+    data[4] = (value >>  0) & 0xFF;
+}
+
+static inline void decode_dpt13(const unsigned char *data, signed int *value) {
+    *value = data[1] << 24 | data[2] << 16 | data[3] << 8 | data[4];
+}
+
+static inline void encode_dpt13(unsigned char *data, signed int value) {
+    data[1] = (value >> 24) & 0xFF;
+    data[2] = (value >> 16) & 0xFF;
+    data[3] = (value >>  8) & 0xFF;
+    data[4] = (value >>  0) & 0xFF;
+}
+
+static inline void decode_dpt14(const unsigned char *data, float *value) {
+    unsigned int rdata = ((data[1]<< 24) | (data[2]<< 16) | (data[3]<< 8) | data[4]);
+    memcpy(value, &rdata, 4);
+}
+
+static inline void encode_dpt14(unsigned char *data, float value) {
+    unsigned int rdata;
+    memcpy(&rdata, &value, 4);
+
+    data[1] = (rdata >> 24) & 0xFF;
+    data[2] = (rdata >> 16) & 0xFF;
+    data[3] = (rdata >>  8) & 0xFF;
+    data[4] = (rdata >>  0) & 0xFF;
+}
+
+static inline void decode_dpt16(const unsigned char *data, char *value) {
+    memcpy(value, data + 1, 14);
+}
+
+static inline void encode_dpt16(unsigned char *data, const char *value) {
+    memcpy(data + 1, value, 14);
+}
+
+static inline void decode_dpt17(const unsigned char *data, unsigned char *scene) {
+    *scene = data[1] & 0x3F;
+}
+
+static inline void encode_dpt17(unsigned char *data, unsigned char scene) {
+    data[1] = scene & 0x3F;
+}
+
+static inline void decode_dpt18(const unsigned char *data, bool *learn, unsigned char *scene) {
+    *learn = data[1] & 0x80;
+    *scene = data[1] & 0x3F;
+}
+
+static inline void encode_dpt18(unsigned char *data, bool learn, unsigned char scene) {
+    data[1] = (learn ? 0x80 : 0x00) | (scene & 0x3F);
+}
+
+static inline void decode_dpt225(const unsigned char *data, unsigned short *time_period, unsigned char *percent) {
+    *time_period = data[1] << 8 | data[2];
+    *percent = data[3];
+}
+
+static inline void encode_dpt225(unsigned char *data, unsigned short time_period, unsigned char percent) {
+    data[1] = (time_period & 0xFF00) >> 8;
+    data[2] = time_period & 0xFF;
+    data[3] = percent;
+}
+
+static inline void decode_dpt232(const unsigned char *data, unsigned char *r, unsigned char *g, unsigned char *b) {
+    *r = data[1];
+    *g = data[2];
+    *b = data[3];
+}
+
+static inline void encode_dpt232(unsigned char *data, unsigned char r, unsigned char g, unsigned char b) {
+    data[1] = r;
+    data[2] = g;
+    data[3] = b;
+}
+
+/* Typed storage of a decoded value.
+ *
+ * Scalar DPTs are kept as bool, integer or double. Composite DPTs (time,
+ * date, string, colour, ...) keep their raw bytes data[1..size], raw[0]
+ * is always 0, and are only turned into a QVariant when read. */
+struct KnxValue {
+    enum Kind : quint8 {
+        Invalid = 0,
+        Bool,
+        Int,
+        UInt,
+        Float,
+        Raw
+    };
+
+    Kind kind {Invalid};
+    quint8 len {0};
+    union {
+        bool b;
+        qint64 i;
+        quint64 u;
+        double f;
+        unsigned char raw[15];
+    };
+
+    KnxValue() : u(0) {}
+
+    bool isValid() const {
+        return kind != Invalid;
+    }
+
+    bool operator==(const KnxValue &other) const {
+        if(kind != other.kind)
+            return false;
+        switch(kind)
+        {
+        case Invalid: return true;
+        case Bool: return b == other.b;
+        case Int: return i == other.i;
+        case UInt: return u == other.u;
+        case Float: return f == other.f;
+        case Raw: return len == other.len && memcmp(raw, other.raw, len) == 0;
+        }
+        return false;
+    }
+
+    bool operator!=(const KnxValue &other) const {
+        return !(*this == other);
+    }
+};
+
+/* Encoder/decoder of one datapoint type, resolved once per KnxObject */
+struct KnxDptCodec {
+    quint8 main;
+    qint16 sub;         // -1 matches every subtype
+    quint8 size;        // payload bytes after data[0], 0 for 6-bit DPTs
+    void (*decode)(const unsigned char *data, KnxValue &value);
+    QVariant (*toVariant)(const KnxValue &value);
+    bool (*encode)(const QVariant &value, unsigned char *data);
+};
+
+/* Codec of dpt (main << 8 | sub), nullptr if the type is not supported */
+const KnxDptCodec *knxDptCodec(quint16 dpt);
+
+/* Frame length (APCI included) carrying a value of this codec */
+static inline int knxDptFrameSize(const KnxDptCodec *codec) {
+    return 2 + codec->size;
+}
+
+/* Normalize a QVariant through the codec (encode then decode), false if it can't be encoded */
+bool knxDptFromVariant(const KnxDptCodec *codec, const QVariant &variant, KnxValue &value);
+
+#endif // KNXDPT_H
@@ -0,0 +1,206 @@
+#include "knxdptbatch.h"
+#include <QByteArray>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define KNX_DPT_X86
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define KNX_DPT_NEON
+#endif
+
+/* Scalar reference, also used for the tail of the vector kernels.
+ * mant << exp is exact in a float (12 significant bits), the scale by
+ * 0.01 is done in double then rounded to float, as decode_dpt9() does. */
+static void decodeDpt9Scalar(const unsigned char *payloads, float *values, qsizetype count)
+{
+    for(qsizetype i = 0; i < count; i++)
+    {
+        const int raw = payloads[2 * i] << 8 | payloads[2 * i + 1];
+        const int mant = (raw & 0x07ff) - ((raw & 0x8000) >> 4);
+        const int exp = (raw >> 11) & 0x0f;
+        values[i] = static_cast<float>((1 << exp) * 0.01 * mant);
+    }
+}
+
+static void decodeDpt14Scalar(const unsigned char *payloads, float *values, qsizetype count)
+{
+    for(qsizetype i = 0; i < count; i++)
+    {
+        const unsigned char *p = payloads + 4 * i;
+        const quint32 raw = quint32(p[0]) << 24 | quint32(p[1]) << 16 | quint32(p[2]) << 8 | p[3];
+        memcpy(values + i, &raw, sizeof(raw));
+    }
+}
+
+#ifdef KNX_DPT_X86
+
+/* 8 big-endian DPT 9 payloads to signed mantissas and exponents (16-bit lanes) */
+static inline void splitDpt9Sse2(__m128i raw, __m128i &mant, __m128i &exp)
+{
+    raw = _mm_or_si128(_mm_slli_epi16(raw, 8), _mm_srli_epi16(raw, 8));
+    mant = _mm_sub_epi16(_mm_and_si128(raw, _mm_set1_epi16(0x07ff)),
+                         _mm_srli_epi16(_mm_and_si128(raw, _mm_set1_epi16(static_cast<short>(0x8000))), 4));
+    exp = _mm_and_si128(_mm_srli_epi16(raw, 11), _mm_set1_epi16(0x0f));
+}
+
+/* 4 floats scaled by 0.01 in double, rounded back to float */
+static inline __m128 scaleSse2(__m128 v)
+{
+    const __m128d scale = _mm_set1_pd(0.01);
+    const __m128 low = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(v), scale));
+    const __m128 high = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), scale));
+    return _mm_movelh_ps(low, high);
+}
+
+static void decodeDpt9Sse2(const unsigned char *payloads, float *values, qsizetype count)
+{
+    qsizetype i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        __m128i mant, exp;
+        splitDpt9Sse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(payloads + 2 * i)), mant, exp);
+
+        /* 2^exp built in the float exponent field, the product is exact */
+        const __m128i mantLow = _mm_srai_epi32(_mm_unpacklo_epi16(mant, mant), 16);
+        const __m128i mantHigh = _mm_srai_epi32(_mm_unpackhi_epi16(mant, mant), 16);
+        const __m128i bias = _mm_set1_epi32(127);
+        const __m128 pow2Low = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_unpacklo_epi16(exp, _mm_setzero_si128()), bias), 23));
+        const __m128 pow2High = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_unpackhi_epi16(exp, _mm_setzero_si128()), bias), 23));
+
+        _mm_storeu_ps(values + i, scaleSse2(_mm_mul_ps(_mm_cvtepi32_ps(mantLow), pow2Low)));
+        _mm_storeu_ps(values + i + 4, scaleSse2(_mm_mul_ps(_mm_cvtepi32_ps(mantHigh), pow2High)));
+    }
+    decodeDpt9Scalar(payloads + 2 * i, values + i, count - i);
+}
+
+static void decodeDpt14Sse2(const unsigned char *payloads, float *values, qsizetype count)
+{
+    qsizetype i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(payloads + 4 * i));
+        /* Byte swap of each 32-bit lane without SSSE3 */
+        raw = _mm_or_si128(_mm_slli_epi16(raw, 8), _mm_srli_epi16(raw, 8));
+        raw = _mm_shufflehi_epi16(_mm_shufflelo_epi16(raw, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(values + i), raw);
+    }
+    decodeDpt14Scalar(payloads + 4 * i, values + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void decodeDpt9Avx2(const unsigned char *payloads, float *values, qsizetype count)
+{
+    const __m256d scale = _mm256_set1_pd(0.01);
+    qsizetype i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        __m128i mant, exp;
+        splitDpt9Sse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(payloads + 2 * i)), mant, exp);
+
+        const __m256i scaled = _mm256_sllv_epi32(_mm256_cvtepi16_epi32(mant), _mm256_cvtepu16_epi32(exp));
+        const __m128 low = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(scaled)), scale));
+        const __m128 high = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(scaled, 1)), scale));
+        _mm_storeu_ps(values + i, low);
+        _mm_storeu_ps(values + i + 4, high);
+    }
+    decodeDpt9Scalar(payloads + 2 * i, values + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void decodeDpt14Avx2(const unsigned char *payloads, float *values, qsizetype count)
+{
+    const __m256i swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    qsizetype i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        const __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(payloads + 4 * i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(values + i), _mm256_shuffle_epi8(raw, swap));
+    }
+    decodeDpt14Scalar(payloads + 4 * i, values + i, count - i);
+}
+
+#endif // KNX_DPT_X86
+
+#ifdef KNX_DPT_NEON
+
+static void decodeDpt9Neon(const unsigned char *payloads, float *values, qsizetype count)
+{
+    const float64x2_t scale = vdupq_n_f64(0.01);
+    qsizetype i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        const uint16x8_t raw = vreinterpretq_u16_u8(vrev16q_u8(vld1q_u8(payloads + 2 * i)));
+        const int16x8_t mant = vsubq_s16(vreinterpretq_s16_u16(vandq_u16(raw, vdupq_n_u16(0x07ff))),
+                                         vreinterpretq_s16_u16(vshrq_n_u16(vandq_u16(raw, vdupq_n_u16(0x8000)), 4)));
+        const int16x8_t exp = vreinterpretq_s16_u16(vandq_u16(vshrq_n_u16(raw, 11), vdupq_n_u16(0x0f)));
+
+        const int32x4_t scaled[2] = {
+            vshlq_s32(vmovl_s16(vget_low_s16(mant)), vmovl_s16(vget_low_s16(exp))),
+            vshlq_s32(vmovl_s16(vget_high_s16(mant)), vmovl_s16(vget_high_s16(exp)))
+        };
+        for(int half = 0; half < 2; half++)
+        {
+            const float64x2_t low = vmulq_f64(vcvtq_f64_s64(vmovl_s32(vget_low_s32(scaled[half]))), scale);
+            const float64x2_t high = vmulq_f64(vcvtq_f64_s64(vmovl_s32(vget_high_s32(scaled[half]))), scale);
+            vst1q_f32(values + i + 4 * half, vcvt_high_f32_f64(vcvt_f32_f64(low), high));
+        }
+    }
+    decodeDpt9Scalar(payloads + 2 * i, values + i, count - i);
+}
+
+static void decodeDpt14Neon(const unsigned char *payloads, float *values, qsizetype count)
+{
+    qsizetype i = 0;
+    for(; i + 4 <= count; i += 4)
+        vst1q_f32(values + i, vreinterpretq_f32_u8(vrev32q_u8(vld1q_u8(payloads + 4 * i))));
+    decodeDpt14Scalar(payloads + 4 * i, values + i, count - i);
+}
+
+#endif // KNX_DPT_NEON
+
+typedef void (*DecodeKernel)(const unsigned char *payloads, float *values, qsizetype count);
+
+struct DptBatchKernels {
+    DecodeKernel dpt9;
+    DecodeKernel dpt14;
+    const char *name;
+};
+
+static DptBatchKernels selectKernels()
+{
+    /* KNX_DPT_KERNEL=scalar|sse2 forces a slower kernel, see README.md */
+    const QByteArray forced = qgetenv("KNX_DPT_KERNEL");
+    if(forced == "scalar")
+        return { decodeDpt9Scalar, decodeDpt14Scalar, "scalar" };
+#if defined(KNX_DPT_X86)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2") && forced != "sse2")
+        return { decodeDpt9Avx2, decodeDpt14Avx2, "avx2" };
+    return { decodeDpt9Sse2, decodeDpt14Sse2, "sse2" };
+#elif defined(KNX_DPT_NEON)
+    return { decodeDpt9Neon, decodeDpt14Neon, "neon" };
+#else
+    return { decodeDpt9Scalar, decodeDpt14Scalar, "scalar" };
+#endif
+}
+
+static const DptBatchKernels &kernels()
+{
+    static const DptBatchKernels selected = selectKernels();
+    return selected;
+}
+
+void knxDecodeDpt9(const unsigned char *payloads, float *values, qsizetype count) {
+    kernels().dpt9(payloads, values, count);
+}
+
+void knxDecodeDpt14(const unsigned char *payloads, float *values, qsizetype count) {
+    kernels().dpt14(payloads, values, count);
+}
+
+const char *knxDptBatchKernel() {
+    return kernels().name;
+}
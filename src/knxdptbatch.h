@@ -0,0 +1,20 @@
+#ifndef KNXDPTBATCH_H
+#define KNXDPTBATCH_H
+
+#include <QtGlobal>
+
+/* Batched decoding of the float DPTs.
+ *
+ * payloads holds count packed payloads as carried on the bus (big-endian,
+ * 2 bytes each for DPT 9, 4 bytes each for DPT 14, without the APCI byte).
+ * The results are bit-exact with decode_dpt9() and decode_dpt14(). The
+ * kernel is chosen once at runtime: AVX2, SSE2 or NEON when available,
+ * scalar otherwise, KNX_DPT_KERNEL=scalar|sse2 in the environment forces
+ * a slower one. */
+void knxDecodeDpt9(const unsigned char *payloads, float *values, qsizetype count);
+void knxDecodeDpt14(const unsigned char *payloads, float *values, qsizetype count);
+
+/* Name of the kernel in use, for the logs */
+const char *knxDptBatchKernel();
+
+#endif // KNXDPTBATCH_H
@@ -0,0 +1,59 @@
+#include "knxdtransport.h"
+#include <eibclient.h>
+
+KnxdTransport::KnxdTransport(const QString &url, QObject *parent)
+    : KnxTransport{parent}
+    , m_url(url)
+{
+}
+
+KnxdTransport::~KnxdTransport()
+{
+    close();
+}
+
+bool KnxdTransport::open()
+{
+    close();
+    m_knxd = EIBSocketURL(m_url.toStdString().c_str());
+    if (!m_knxd || EIBOpen_GroupSocket (m_knxd, 0) == -1)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void KnxdTransport::close()
+{
+    if(m_knxd)
+    {
+        EIBClose(m_knxd);
+        m_knxd = nullptr;
+    }
+}
+
+int KnxdTransport::fd() const {
+    return m_knxd ? EIB_Poll_FD(m_knxd) : -1;
+}
+
+int KnxdTransport::pending() {
+    return m_knxd ? EIB_Poll_Complete(m_knxd) : -1;
+}
+
+int KnxdTransport::read(unsigned char *buffer, int size, quint16 &src, quint16 &dest)
+{
+    if(!m_knxd)
+        return -1;
+    eibaddr_t s;
+    eibaddr_t d;
+    int len = EIBGetGroup_Src(m_knxd, size, buffer, &s, &d);
+    src = s;
+    dest = d;
+    return len;
+}
+
+bool KnxdTransport::send(quint16 dest, const unsigned char *frame, int len)
+{
+    return m_knxd && EIBSendGroup(m_knxd, dest, len, frame) != -1;
+}
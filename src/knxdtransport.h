@@ -0,0 +1,29 @@
+#ifndef KNXDTRANSPORT_H
+#define KNXDTRANSPORT_H
+
+#include "knxtransport.h"
+
+struct _EIBConnection;
+
+/* Group socket of a knxd daemon, url as accepted by EIBSocketURL */
+class KnxdTransport : public KnxTransport
+{
+    Q_OBJECT
+
+public:
+    explicit KnxdTransport(const QString &url, QObject *parent = nullptr);
+    ~KnxdTransport();
+
+    bool open() override;
+    void close() override;
+    int fd() const override;
+    int pending() override;
+    int read(unsigned char *buffer, int size, quint16 &src, quint16 &dest) override;
+    bool send(quint16 dest, const unsigned char *frame, int len) override;
+
+private:
+    QString m_url;
+    _EIBConnection *m_knxd {nullptr};
+};
+
+#endif // KNXDTRANSPORT_H
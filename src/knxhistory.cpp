@@ -0,0 +1,144 @@
+#include "knxhistory.h"
+#include <QDateTime>
+#include <algorithm>
+#include <cstring>
+
+KnxHistory::KnxHistory()
+    : m_epoch(QDateTime::currentMSecsSinceEpoch())
+{
+}
+
+void KnxHistory::setup(int depth, const QList<quint16> &gads, const QList<quint8> &sizes)
+{
+    clear();
+    if(depth <= 0 || gads.isEmpty())
+        return;
+
+    m_depth = depth;
+    m_count = static_cast<int>(gads.size());
+    m_slots.reset(new qint32[65536]);
+    std::fill(m_slots.get(), m_slots.get() + 65536, -1);
+    m_rings.reset(new Ring[m_count]());
+    m_samples.reset(new Sample[static_cast<size_t>(m_count) * static_cast<size_t>(m_depth)]);
+    for(int i = 0; i < m_count; i++)
+    {
+        m_slots[gads[i]] = i;
+        m_rings[i].size = sizes[i];
+    }
+}
+
+void KnxHistory::clear()
+{
+    m_depth = 0;
+    m_count = 0;
+    m_slots.reset();
+    m_rings.reset();
+    m_samples.reset();
+}
+
+void KnxHistory::record(quint16 gad, const unsigned char *buffer, int len, qint64 msecs)
+{
+    if(!m_slots)
+        return;
+    const qint32 slot = m_slots[gad];
+    if(slot < 0)
+        return;
+    Ring &ring = m_rings[slot];
+    if(len < 2 + ring.size)
+        return;
+
+    Sample *samples = m_samples.get() + static_cast<size_t>(slot) * static_cast<size_t>(m_depth);
+    quint32 time = _toTime(msecs);
+    /* Keep the ring sorted if the clock steps back */
+    if(ring.count > 0)
+        time = std::max(time, samples[(ring.head + m_depth - 1) % m_depth].time);
+
+    Sample &sample = samples[ring.head];
+    sample.time = time;
+    memset(sample.data, 0, sizeof(sample.data));
+    if(ring.size == 0)
+        sample.data[0] = buffer[1] & 0x3F;
+    else
+        memcpy(sample.data, buffer + 2, ring.size);
+
+    ring.head = (ring.head + 1) % m_depth;
+    if(ring.count < static_cast<quint32>(m_depth))
+        ring.count++;
+}
+
+QList<KnxHistory::Sample> KnxHistory::range(quint16 gad, qint64 from, qint64 to) const
+{
+    QList<Sample> samples;
+    if(!isRecorded(gad) || to < from)
+        return samples;
+    const int slot = m_slots[gad];
+    const Ring &ring = m_rings[slot];
+
+    /* Samples are sorted by time: binary search the first one in range */
+    const quint32 first = _toTime(from);
+    quint32 low = 0;
+    quint32 high = ring.count;
+    while(low < high)
+    {
+        const quint32 mid = low + (high - low) / 2;
+        if(_at(slot, mid).time < first)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    const quint32 last = _toTime(to);
+    for(quint32 i = low; i < ring.count; i++)
+    {
+        const Sample &sample = _at(slot, i);
+        if(sample.time > last)
+            break;
+        samples.append(sample);
+    }
+    return samples;
+}
+
+void KnxHistory::payload(quint16 gad, const Sample &sample, unsigned char *data) const
+{
+    const quint8 size = isRecorded(gad) ? m_rings[m_slots[gad]].size : 0;
+    data[0] = 0;
+    if(size == 0)
+        data[0] = sample.data[0];
+    else
+        memcpy(data + 1, sample.data, size);
+}
+
+qint64 KnxHistory::toMSecs(quint32 time) const {
+    return m_epoch + static_cast<qint64>(time) * 100;
+}
+
+int KnxHistory::depth() const {
+    return m_depth;
+}
+
+int KnxHistory::count() const {
+    return m_count;
+}
+
+qsizetype KnxHistory::memory() const
+{
+    if(!m_slots)
+        return 0;
+    return 65536 * static_cast<qsizetype>(sizeof(qint32))
+           + m_count * static_cast<qsizetype>(sizeof(Ring))
+           + static_cast<qsizetype>(m_count) * m_depth * static_cast<qsizetype>(sizeof(Sample));
+}
+
+quint32 KnxHistory::_toTime(qint64 msecs) const
+{
+    if(msecs <= m_epoch)
+        return 0;
+    return static_cast<quint32>(std::min<qint64>((msecs - m_epoch) / 100, 0xFFFFFFFF));
+}
+
+const KnxHistory::Sample &KnxHistory::_at(int ring, quint32 index) const
+{
+    const Ring &r = m_rings[ring];
+    const quint32 position = (r.head + m_depth - r.count + index) % m_depth;
+    return m_samples[static_cast<size_t>(ring) * static_cast<size_t>(m_depth) + position];
+}
@@ -0,0 +1,74 @@
+#ifndef KNXHISTORY_H
+#define KNXHISTORY_H
+
+#include <QList>
+#include <QtGlobal>
+#include <memory>
+
+/* Fixed-memory history of the values of the group addresses.
+ *
+ * Every recorded group address owns a ring of depth samples carved out of
+ * a single slab allocated by setup(). A sample is 8 bytes: the time in
+ * tenths of second since the history epoch and the raw payload, so only
+ * DPTs up to 4 bytes are recorded. Recording is a table lookup and a
+ * store; values are decoded with the DPT codec when queried. */
+class KnxHistory
+{
+public:
+    struct Sample {
+        quint32 time;           // 1/10 s since epoch()
+        unsigned char data[4];  // data[0] of 6-bit DPTs, else the payload
+    };
+    static_assert(sizeof(Sample) == 8, "KnxHistory::Sample must stay 8 bytes");
+
+    /* Largest DPT payload kept */
+    static constexpr int MaxPayload = 4;
+
+    KnxHistory();
+
+    KnxHistory(const KnxHistory &) = delete;
+    KnxHistory &operator=(const KnxHistory &) = delete;
+
+    /* Allocate depth samples for each of gads, 0 disables the history.
+     * sizes holds the payload size of the DPT of each group address. */
+    void setup(int depth, const QList<quint16> &gads, const QList<quint8> &sizes);
+    void clear();
+
+    inline bool isRecorded(quint16 gad) const {
+        return m_slots && m_slots[gad] >= 0;
+    }
+
+    /* buffer is the frame from the APCI, as given to KnxObject::reciveFrame() */
+    void record(quint16 gad, const unsigned char *buffer, int len, qint64 msecs);
+
+    /* Samples of gad between from and to (ms since Unix epoch), oldest first */
+    QList<Sample> range(quint16 gad, qint64 from, qint64 to) const;
+
+    /* Rebuild the data[] given to a KnxDptCodec::decode() */
+    void payload(quint16 gad, const Sample &sample, unsigned char *data) const;
+
+    qint64 toMSecs(quint32 time) const;
+
+    int depth() const;
+    int count() const;
+    qsizetype memory() const;
+
+private:
+    struct Ring {
+        quint32 head;           // next write position
+        quint32 count;
+        quint8 size;            // payload bytes, 0 for 6-bit DPTs
+    };
+
+    int m_depth {0};
+    int m_count {0};
+    qint64 m_epoch {0};
+    std::unique_ptr<qint32[]> m_slots;      // gad -> ring index, -1 when not recorded
+    std::unique_ptr<Ring[]> m_rings;
+    std::unique_ptr<Sample[]> m_samples;    // m_count * m_depth
+
+    quint32 _toTime(qint64 msecs) const;
+    const Sample &_at(int ring, quint32 index) const;
+};
+
+#endif // KNXHISTORY_H
@@ -0,0 +1,223 @@
+#include "knxjournal.h"
+#include "knxlogging.h"
+#include "knxtelegram.h"
+#include <QDateTime>
+#include <QDir>
+#include <unistd.h>
+
+#define KNX_JOURNAL_VERSION     (1)
+
+static const char s_magic[4] = { 'K', 'N', 'X', 'J' };
+
+KnxJournal::KnxJournal()
+{
+}
+
+KnxJournal::~KnxJournal()
+{
+    close();
+}
+
+bool KnxJournal::open(const QString &directory, const QString &name)
+{
+    close();
+    if(directory.isEmpty())
+        return false;
+    m_directory = directory;
+    m_name = name;
+    m_segment = 0;
+    m_records = 0;
+    m_writeTime = 0;
+    if(!QDir().mkpath(directory))
+    {
+        qCWarning(lcKnx) << "Can't create KNX journal directory" << directory;
+        return false;
+    }
+    return _openSegment();
+}
+
+void KnxJournal::close()
+{
+    if(!m_file.isOpen())
+        return;
+    flush();
+    _sync(knxTimestamp(), true);
+    m_file.close();
+    if(m_records > 0)
+    {
+        qCInfo(lcKnx).noquote() << "KNX journal" << m_name << "closed," << m_records << "telegrams,"
+                                << writeCost() << "ns per telegram written";
+    }
+}
+
+bool KnxJournal::isOpen() const {
+    return m_file.isOpen();
+}
+
+int KnxJournal::flushInterval() const {
+    return m_flushInterval;
+}
+
+void KnxJournal::setFlushInterval(int flushInterval) {
+    m_flushInterval = qMax(0, flushInterval);
+}
+
+int KnxJournal::syncInterval() const {
+    return m_syncInterval;
+}
+
+void KnxJournal::setSyncInterval(int syncInterval) {
+    m_syncInterval = syncInterval;
+}
+
+void KnxJournal::flush()
+{
+    if(m_pending == 0 || !m_file.isOpen())
+        return;
+
+    const qint64 start = knxTimestamp();
+    const qint64 bytes = static_cast<qint64>(m_pending) * static_cast<qint64>(sizeof(Record));
+    if(m_file.write(reinterpret_cast<const char *>(m_batch), bytes) != bytes)
+    {
+        qCWarning(lcKnx) << "KNX journal write error" << m_file.fileName() << m_file.errorString() << ", journal stopped";
+        m_pending = 0;
+        m_file.close();
+        return;
+    }
+    m_records += m_pending;
+    m_segmentBytes += bytes;
+    m_pending = 0;
+    _sync(start, false);
+    m_writeTime += knxTimestamp() - start;
+
+    if(m_segmentBytes >= SegmentSize)
+    {
+        _sync(start, true);
+        m_file.close();
+        _openSegment();
+    }
+}
+
+quint64 KnxJournal::records() const {
+    return m_records;
+}
+
+double KnxJournal::writeCost() const {
+    return m_records > 0 ? static_cast<double>(m_writeTime) / m_records : 0.0;
+}
+
+QStringList KnxJournal::segments(const QString &directory, const QString &name)
+{
+    /* Names sort chronologically: date, then zero-padded sequence. The
+     * dash keeps link1 from matching the segments of link10 */
+    QDir dir(directory);
+    QStringList files = dir.entryList({name + QStringLiteral("-*.knxj")}, QDir::Files, QDir::Name);
+    for(QString &file: files)
+        file = dir.filePath(file);
+    return files;
+}
+
+bool KnxJournal::_openSegment()
+{
+    const QString name = QStringLiteral("%1-%2-%3.knxj")
+                             .arg(m_name, QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss")))
+                             .arg(m_segment++, 4, 10, QLatin1Char('0'));
+    m_file.setFileName(QDir(m_directory).filePath(name));
+    if(!m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered))
+    {
+        qCWarning(lcKnx) << "Can't open KNX journal" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+
+    SegmentHeader header {};
+    memcpy(header.magic, s_magic, sizeof(s_magic));
+    header.version = KNX_JOURNAL_VERSION;
+    header.recordSize = sizeof(Record);
+    header.wallClock = QDateTime::currentMSecsSinceEpoch();
+    header.monotonic = knxTimestamp();
+    if(m_file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != static_cast<qint64>(sizeof(header)))
+    {
+        qCWarning(lcKnx) << "Can't write KNX journal" << m_file.fileName() << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+    m_segmentBytes = sizeof(header);
+    m_lastSync = header.monotonic;
+    return true;
+}
+
+void KnxJournal::_sync(qint64 now, bool force)
+{
+    if(!m_file.isOpen() || (!force && m_syncInterval < 0))
+        return;
+    if(!force && m_syncInterval > 0 && now - m_lastSync < m_syncInterval * Q_INT64_C(1000000))
+        return;
+    ::fdatasync(m_file.handle());
+    m_lastSync = now;
+}
+
+
+KnxJournalReader::KnxJournalReader()
+{
+}
+
+KnxJournalReader::~KnxJournalReader()
+{
+    close();
+}
+
+bool KnxJournalReader::open(const QString &path)
+{
+    close();
+    m_file.setFileName(path);
+    if(!m_file.open(QIODevice::ReadOnly))
+    {
+        m_error = QStringLiteral("Can't open %1").arg(path);
+        return false;
+    }
+    if(m_file.size() < static_cast<qint64>(sizeof(KnxJournal::SegmentHeader))
+        || (m_map = m_file.map(0, m_file.size())) == nullptr)
+    {
+        m_error = QStringLiteral("Can't map %1").arg(path);
+        close();
+        return false;
+    }
+
+    m_header = reinterpret_cast<const KnxJournal::SegmentHeader *>(m_map);
+    if(memcmp(m_header->magic, s_magic, sizeof(s_magic)) != 0 || m_header->version != KNX_JOURNAL_VERSION
+        || m_header->recordSize != sizeof(KnxJournal::Record))
+    {
+        m_error = QStringLiteral("%1 is not a KNX journal").arg(path);
+        close();
+        return false;
+    }
+    m_records = reinterpret_cast<const KnxJournal::Record *>(m_map + sizeof(KnxJournal::SegmentHeader));
+    m_size = (m_file.size() - static_cast<qint64>(sizeof(KnxJournal::SegmentHeader))) / static_cast<qint64>(sizeof(KnxJournal::Record));
+    return true;
+}
+
+void KnxJournalReader::close()
+{
+    if(m_map)
+    {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    if(m_file.isOpen())
+        m_file.close();
+    m_header = nullptr;
+    m_records = nullptr;
+    m_size = 0;
+}
+
+QString KnxJournalReader::errorString() const {
+    return m_error;
+}
+
+qsizetype KnxJournalReader::size() const {
+    return m_size;
+}
+
+qint64 KnxJournalReader::wallClock(qint64 timestamp) const {
+    return m_header->wallClock * 1000000 + (timestamp - m_header->monotonic);
+}
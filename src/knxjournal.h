@@ -0,0 +1,148 @@
+#ifndef KNXJOURNAL_H
+#define KNXJOURNAL_H
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <cstring>
+
+/* Append-only binary journal of the telegrams of a link.
+ *
+ * The journal is a directory of segments named <name>-<date>-<seq>.knxj.
+ * A segment is a small header followed by fixed-size records holding the
+ * monotonic timestamp, source, destination, APCI and frame of one rx or
+ * tx telegram. Records are gathered in a page-sized batch and appended
+ * with one write() when the batch is full or older than flushInterval;
+ * syncInterval bounds the data lost on power failure (fdatasync after
+ * every write when 0, at most every syncInterval ms when positive, left
+ * to the kernel when negative). A segment is closed and a new one started
+ * past SegmentSize, a torn last record is ignored by the reader. */
+class KnxJournal
+{
+public:
+    enum Flag : quint8 {
+        Transmit = 0x01         // Sent by us, received otherwise
+    };
+
+    struct Record {
+        qint64 timestamp;       // knxTimestamp(), ns
+        quint16 src;
+        quint16 dest;
+        quint8 flags;
+        quint8 apci;
+        quint8 len;
+        quint8 reserved;
+        unsigned char frame[16];
+    };
+    static_assert(sizeof(Record) == 32, "KnxJournal::Record must stay 32 bytes");
+
+    struct SegmentHeader {
+        char magic[4];
+        quint16 version;
+        quint16 recordSize;
+        qint64 wallClock;       // ms since epoch when the segment was opened
+        qint64 monotonic;       // knxTimestamp() at the same time
+        quint32 flags;
+        quint32 reserved;
+    };
+    static_assert(sizeof(SegmentHeader) == 32, "KnxJournal::SegmentHeader must stay 32 bytes");
+
+    static constexpr qint64 SegmentSize = 64 * 1024 * 1024;
+    static constexpr int BatchSize = 4096 / sizeof(Record);
+
+    KnxJournal();
+    ~KnxJournal();
+
+    KnxJournal(const KnxJournal &) = delete;
+    KnxJournal &operator=(const KnxJournal &) = delete;
+
+    /* Start a new segment in directory, an empty directory disables the journal */
+    bool open(const QString &directory, const QString &name);
+    void close();
+    bool isOpen() const;
+
+    int flushInterval() const;
+    void setFlushInterval(int flushInterval);
+    int syncInterval() const;
+    void setSyncInterval(int syncInterval);
+
+    inline void record(qint64 timestamp, quint16 src, quint16 dest, bool transmit, const unsigned char *frame, int len)
+    {
+        if(!m_file.isOpen())
+            return;
+        Record &rec = m_batch[m_pending++];
+        rec.timestamp = timestamp;
+        rec.src = src;
+        rec.dest = dest;
+        rec.flags = transmit ? Transmit : 0;
+        rec.apci = (len >= 2) ? static_cast<quint8>(((frame[0] & 0x03) << 2) | ((frame[1] & 0xC0) >> 6)) : 0;
+        rec.len = static_cast<quint8>(qMin(len, static_cast<int>(sizeof(rec.frame))));
+        rec.reserved = 0;
+        memcpy(rec.frame, frame, rec.len);
+        if(m_pending == 1)
+            m_batchStart = timestamp;
+        if(m_pending == BatchSize || timestamp - m_batchStart >= m_flushInterval * Q_INT64_C(1000000))
+            flush();
+    }
+
+    /* Write the pending records, called periodically for idle links */
+    void flush();
+
+    quint64 records() const;
+    /* Average cost of a batch write (and sync) per record, ns */
+    double writeCost() const;
+
+    /* Segments of the journal name in directory, in chronological order */
+    static QStringList segments(const QString &directory, const QString &name);
+
+private:
+    QString m_directory;
+    QString m_name;
+    QFile m_file;
+    int m_segment {0};
+    qint64 m_segmentBytes {0};
+    int m_flushInterval {1000};
+    int m_syncInterval {0};
+    qint64 m_lastSync {0};
+    Record m_batch[BatchSize];
+    int m_pending {0};
+    qint64 m_batchStart {0};
+    quint64 m_records {0};
+    qint64 m_writeTime {0};
+
+    bool _openSegment();
+    void _sync(qint64 now, bool force);
+};
+
+/* Read-only view of a journal segment, memory-mapped */
+class KnxJournalReader
+{
+public:
+    KnxJournalReader();
+    ~KnxJournalReader();
+
+    KnxJournalReader(const KnxJournalReader &) = delete;
+    KnxJournalReader &operator=(const KnxJournalReader &) = delete;
+
+    bool open(const QString &path);
+    void close();
+    QString errorString() const;
+
+    qsizetype size() const;
+    inline const KnxJournal::Record &record(qsizetype index) const {
+        return m_records[index];
+    }
+
+    /* Wall clock of a record timestamp, ns since epoch */
+    qint64 wallClock(qint64 timestamp) const;
+
+private:
+    QFile m_file;
+    uchar *m_map {nullptr};
+    const KnxJournal::SegmentHeader *m_header {nullptr};
+    const KnxJournal::Record *m_records {nullptr};
+    qsizetype m_size {0};
+    QString m_error;
+};
+
+#endif // KNXJOURNAL_H
@@ -0,0 +1,5 @@
+#include "knxlogging.h"
+
+Q_LOGGING_CATEGORY(lcKnx, "kaza.knx")
+Q_LOGGING_CATEGORY(lcKnxFrame, "kaza.knx.frame", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcKnxValue, "kaza.knx.value", QtInfoMsg)
@@ -0,0 +1,12 @@
+#ifndef KNXLOGGING_H
+#define KNXLOGGING_H
+
+#include <QLoggingCategory>
+
+/* qCDebug only evaluates its arguments when the category is enabled,
+ * enable at runtime with QT_LOGGING_RULES="kaza.knx.*.debug=true" */
+Q_DECLARE_LOGGING_CATEGORY(lcKnx)          // Bus life cycle and configuration
+Q_DECLARE_LOGGING_CATEGORY(lcKnxFrame)     // Per telegram traces, debug off by default
+Q_DECLARE_LOGGING_CATEGORY(lcKnxValue)     // Per object value traces, debug off by default
+
+#endif // KNXLOGGING_H
@@ -0,0 +1,75 @@
+#include "knxmetrics.h"
+#include <algorithm>
+
+KnxMetrics::KnxMetrics()
+    : m_gaTotal(new quint32[0x10000]())
+    , m_gaWindow(new quint32[0x10000]())
+{
+    m_active.reserve(1024);
+    m_topTalkers.reserve(TopTalkers);
+}
+
+void KnxMetrics::aggregate(quint64 rxTotal, quint64 txTotal, qint64 now)
+{
+    const double seconds = (m_lastAggregate > 0) ? (now - m_lastAggregate) / 1000000000.0 : 0.0;
+    /* A new connection restarts its totals */
+    if(rxTotal < m_lastRx)
+        m_lastRx = 0;
+    if(txTotal < m_lastTx)
+        m_lastTx = 0;
+    if(seconds > 0.0)
+    {
+        m_rxRate = (rxTotal - m_lastRx) / seconds;
+        m_txRate = (txTotal - m_lastTx) / seconds;
+    }
+    m_lastAggregate = now;
+    m_lastRx = rxTotal;
+    m_lastTx = txTotal;
+
+    const int top = qMin(TopTalkers, static_cast<int>(m_active.size()));
+    std::partial_sort(m_active.begin(), m_active.begin() + top, m_active.end(), [this](quint16 a, quint16 b) {
+        return m_gaWindow[a] > m_gaWindow[b];
+    });
+    m_topTalkers.clear();
+    for(int i = 0; i < top; i++)
+        m_topTalkers.append({m_active[i], seconds > 0.0 ? m_gaWindow[m_active[i]] / seconds : 0.0});
+
+    for(quint16 gad: std::as_const(m_active))
+        m_gaWindow[gad] = 0;
+    m_active.clear();
+}
+
+quint64 KnxMetrics::commands(Command cmd) const {
+    return m_commands[cmd];
+}
+
+quint64 KnxMetrics::unknownTelegrams() const {
+    return m_unknown;
+}
+
+quint64 KnxMetrics::decodeErrors() const {
+    quint64 total = 0;
+    for(quint64 count: m_decodeErrors)
+        total += count;
+    return total;
+}
+
+quint64 KnxMetrics::decodeErrors(quint8 mainType) const {
+    return m_decodeErrors[mainType];
+}
+
+quint32 KnxMetrics::total(quint16 gad) const {
+    return m_gaTotal[gad];
+}
+
+double KnxMetrics::rxRate() const {
+    return m_rxRate;
+}
+
+double KnxMetrics::txRate() const {
+    return m_txRate;
+}
+
+const QList<KnxMetrics::Talker> &KnxMetrics::topTalkers() const {
+    return m_topTalkers;
+}
@@ -0,0 +1,72 @@
+#ifndef KNXMETRICS_H
+#define KNXMETRICS_H
+
+#include <QList>
+#include <QtGlobal>
+#include <memory>
+
+/* Bus traffic counters of the object thread.
+ *
+ * Counting a telegram is a couple of plain increments in flat tables, the
+ * object thread being the only writer. aggregate() is called periodically
+ * to turn the totals into rates and to rank the group addresses of the
+ * last period (top talkers). */
+class KnxMetrics
+{
+public:
+    enum Command {
+        Read = 0,
+        Response,
+        Write,
+        Other,
+        CommandCount
+    };
+
+    struct Talker {
+        quint16 gad;
+        double rate;        // telegrams/s over the last period
+    };
+
+    static constexpr int TopTalkers = 10;
+
+    KnxMetrics();
+
+    void telegram(quint16 gad, int cmd)
+    {
+        m_commands[(cmd >= Read && cmd <= Write) ? cmd : Other]++;
+        m_gaTotal[gad]++;
+        if(m_gaWindow[gad]++ == 0)
+            m_active.append(gad);
+    }
+    void unknown() { m_unknown++; }
+    void decodeError(quint16 dpt) { m_decodeErrors[(dpt >> 8) & 0xFF]++; }
+
+    /* Compute the rates of the period ending now from the connection totals */
+    void aggregate(quint64 rxTotal, quint64 txTotal, qint64 now);
+
+    quint64 commands(Command cmd) const;
+    quint64 unknownTelegrams() const;
+    quint64 decodeErrors() const;
+    quint64 decodeErrors(quint8 mainType) const;
+    quint32 total(quint16 gad) const;
+    double rxRate() const;
+    double txRate() const;
+    const QList<Talker> &topTalkers() const;
+
+private:
+    quint64 m_commands[CommandCount] {};
+    quint64 m_unknown {0};
+    quint64 m_decodeErrors[256] {};
+    std::unique_ptr<quint32[]> m_gaTotal;
+    std::unique_ptr<quint32[]> m_gaWindow;
+    QList<quint16> m_active;
+
+    qint64 m_lastAggregate {0};
+    quint64 m_lastRx {0};
+    quint64 m_lastTx {0};
+    double m_rxRate {0.0};
+    double m_txRate {0.0};
+    QList<Talker> m_topTalkers;
+};
+
+#endif // KNXMETRICS_H
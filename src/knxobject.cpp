@@ -1,432 +1,432 @@
 #include "knxobject.h"
+#include "knxlogging.h"
+#include "knxtelegram.h"
 
-#include <QEventLoop>
+#include <QMetaMethod>
 #include <QTimer>
+#include <algorithm>
+#include <string>
 
 #define KNX_READ            (0x00)
 #define KNX_RESPONSE        (0x01)
 #define KNX_WRITE           (0x02)
 
-static inline QString getUnit(uint16_t type)
+/* Units of the DPTs, sorted by DPT for a binary search. QString::fromRawData()
+ * over the literals lets every object share them without any allocation. */
+static const struct {
+    quint16 dpt;
+    const char16_t *unit;
+} s_units[] = {
+    { 0x0501, u"%" },           // 5.001 percent
+    { 0x0503, u"°" },           // 5.003 angle
+    { 0x0504, u"%" },           // 5.004 percentU8
+    { 0x0601, u"%" },           // 6.001 percentV8
+    { 0x0702, u"ms" },          // 7.002 time_period_msec
+    { 0x0703, u"ms" },          // 7.003 time_period_10msec
+    { 0x0704, u"ms" },          // 7.004 time_period_100msec
+    { 0x0705, u"s" },           // 7.005 time_period_sec
+    { 0x0706, u"min" },         // 7.006 time_period_min
+    { 0x0707, u"h" },           // 7.007 time_period_hrs
+    { 0x070B, u"mm" },          // 7.011 time_period_msec
+    { 0x070C, u"mA" },          // 7.012 current
+    { 0x070D, u"lx" },          // 7.013 brightness
+    { 0x0802, u"ms" },          // 8.002 delta_time_ms
+    { 0x0803, u"ms" },          // 8.003 delta_time_10ms
+    { 0x0804, u"ms" },          // 8.004 delta_time_100ms
+    { 0x0805, u"s" },           // 8.005 delta_time_sec
+    { 0x0806, u"min" },         // 8.006 delta_time_min
+    { 0x0807, u"h" },           // 8.007 delta_time_hrs
+    { 0x080A, u"%" },           // 8.010 percentV16
+    { 0x080B, u"°" },           // 8.011 rotation_angle
+    { 0x080C, u"m" },           // 8.012 length_m
+    { 0x0901, u"°C" },          // 9.001 temperaturev
+    { 0x0902, u"K" },           // 9.002 temperature_difference_2byte
+    { 0x0903, u"K/h" },         // 9.003 temperature_a
+    { 0x0904, u"Lux" },         // 9.004 illuminance
+    { 0x0905, u"m/s" },         // 9.005 wind_speed_ms
+    { 0x0906, u"Pa" },          // 9.006 pressure_2byte
+    { 0x0907, u"%" },           // 9.007 humidity
+    { 0x0908, u"ppm" },         // 9.008 ppm
+    { 0x0909, u"m³/h" },        // 9.009 air_flow
+    { 0x090A, u"s" },           // 9.010 time_1
+    { 0x090B, u"ms" },          // 9.011 time_2
+    { 0x0914, u"mV" },          // 9.020 voltage
+    { 0x0915, u"mA" },          // 9.021 current
+    { 0x0916, u"W/m²" },        // 9.022 power_density
+    { 0x0917, u"K/%" },         // 9.023 kelvin_per_percent
+    { 0x0918, u"kW" },          // 9.024 power_2byte
+    { 0x0919, u"l/h" },         // 9.025 volume_flow
+    { 0x091A, u"l/m²" },        // 9.026 rain_amount
+    { 0x091B, u"°F" },          // 9.027 temperature_f
+    { 0x091C, u"km/h" },        // 9.028 wind_speed_kmh
+    { 0x091D, u"g/m³" },        // 9.029 absolute_humidity
+    { 0x091E, u"μg/m³" },       // 9.030 concentration_ugm3
+    { 0x0C64, u"s" },           // 12.100 long_time_period_sec
+    { 0x0C65, u"min" },         // 12.101 long_time_period_min
+    { 0x0C66, u"h" },           // 12.102 long_time_period_hrs
+    { 0x0D02, u"m³/h" },        // 13.002 flow_rate_m3h
+    { 0x0D0A, u"Wh" },          // 13.010 active_energy
+    { 0x0D0B, u"VAh" },         // 13.011 apparant_energy
+    { 0x0D0C, u"VARh" },        // 13.012 reactive_energy
+    { 0x0D0D, u"kWh" },         // 13.013 active_energy_kwh
+    { 0x0D0E, u"kVAh" },        // 13.014 apparant_energy_kvah
+    { 0x0D0F, u"kVARh" },       // 13.015 reactive_energy_kvarh
+    { 0x0D10, u"MWh" },         // 13.016 active_energy_mwh
+    { 0x0D64, u"s" },           // 13.100 long_delta_timesec
+    { 0x0E00, u"m/s²" },        // 14.000 acceleration
+    { 0x0E01, u"rad/s²" },      // 14.001 acceleration_angular
+    { 0x0E02, u"J/mol" },       // 14.002 activation_energy
+    { 0x0E03, u"s⁻¹" },         // 14.003 activity
+    { 0x0E04, u"mol" },         // 14.004 mol
+    { 0x0E06, u"rad" },         // 14.006 angle_rad
+    { 0x0E07, u"°" },           // 14.007 angle_deg
+    { 0x0E08, u"J s" },         // 14.008 angular_momentum
+    { 0x0E09, u"rad/s" },       // 14.009 angular_velocity
+    { 0x0E0A, u"m²" },          // 14.010 area
+    { 0x0E0B, u"F" },           // 14.011 capacitance
+    { 0x0E0C, u"C/m²" },        // 14.012 charge_density_surface
+    { 0x0E0D, u"C/m³" },        // 14.013 charge_density_volume
+    { 0x0E0E, u"m²/N" },        // 14.014 compressibility
+    { 0x0E0F, u"S" },           // 14.015 conductance
+    { 0x0E10, u"S/m" },         // 14.016 electrical_conductivity
+    { 0x0E11, u"kg/m³" },       // 14.017 density
+    { 0x0E12, u"C" },           // 14.018 electric_charge
+    { 0x0E13, u"A" },           // 14.019 electric_current
+    { 0x0E14, u"A/m²" },        // 14.020 electric_current_density
+    { 0x0E15, u"C m" },         // 14.021 electric_dipole_moment
+    { 0x0E16, u"C/m²" },        // 14.022 electric_displacement
+    { 0x0E17, u"V/m" },         // 14.023 electric_field_strength
+    { 0x0E18, u"c" },           // 14.024 electric_flux
+    { 0x0E19, u"C/m²" },        // 14.025 electric_flux_density
+    { 0x0E1A, u"C/m²" },        // 14.026 electric_polarization
+    { 0x0E1B, u"V" },           // 14.027 electric_potential
+    { 0x0E1C, u"V" },           // 14.028 electric_potential_difference
+    { 0x0E1D, u"A m²" },        // 14.029 electromagnetic_moment
+    { 0x0E1E, u"V" },           // 14.030 electromotive_force
+    { 0x0E1F, u"J" },           // 14.031 energy
+    { 0x0E20, u"N" },           // 14.032 force
+    { 0x0E21, u"Hz" },          // 14.033 frequency
+    { 0x0E22, u"rad/s" },       // 14.034 angular_frequency
+    { 0x0E23, u"J/K" },         // 14.035 heatcapacity
+    { 0x0E24, u"W" },           // 14.036 heatflowrate
+    { 0x0E25, u"J" },           // 14.037 heat_quantity
+    { 0x0E26, u"Ω" },           // 14.038 impedance
+    { 0x0E27, u"m" },           // 14.039 length
+    { 0x0E28, u"lm s" },        // 14.040 light_quantity
+    { 0x0E29, u"cd/m²" },       // 14.041 luminance
+    { 0x0E2A, u"lm" },          // 14.042 luminous_flux
+    { 0x0E2B, u"cd" },          // 14.043 luminous_intensity
+    { 0x0E2C, u"A/m" },         // 14.044 magnetic_field_strength
+    { 0x0E2D, u"Wb" },          // 14.045 magnetic_flux
+    { 0x0E2E, u"T" },           // 14.046 magnetic_flux_density
+    { 0x0E2F, u"A m²" },        // 14.047 magnetic_moment
+    { 0x0E30, u"T" },           // 14.048 magnetic_polarization
+    { 0x0E31, u"A/m" },         // 14.049 magnetization
+    { 0x0E32, u"A" },           // 14.050 magnetomotive_force
+    { 0x0E33, u"kg" },          // 14.051 mass
+    { 0x0E34, u"kg/s" },        // 14.052 mass_flux
+    { 0x0E35, u"N/s" },         // 14.053 momentum
+    { 0x0E36, u"rad" },         // 14.054 phaseanglerad
+    { 0x0E37, u"°" },           // 14.055 phaseangledeg
+    { 0x0E38, u"W" },           // 14.056 power
+    { 0x0E3A, u"Pa" },          // 14.058 pressure
+    { 0x0E3B, u"Ω" },           // 14.059 reactance
+    { 0x0E3C, u"Ω" },           // 14.060 resistance
+    { 0x0E3D, u"Ωm" },          // 14.061 resistivity
+    { 0x0E3E, u"H" },           // 14.062 self_inductance
+    { 0x0E3F, u"sr" },          // 14.063 solid_angle
+    { 0x0E40, u"W/m²" },        // 14.064 sound_intensity
+    { 0x0E41, u"m/s" },         // 14.065 speed
+    { 0x0E42, u"Pa" },          // 14.066 stress
+    { 0x0E43, u"N/m" },         // 14.067 surface_tension
+    { 0x0E44, u"°C" },          // 14.068 common_temperature
+    { 0x0E45, u"K" },           // 14.069 absolute_temperature
+    { 0x0E46, u"K" },           // 14.070 temperature_difference
+    { 0x0E47, u"J/K" },         // 14.071 thermal_capacity
+    { 0x0E48, u"W/mK" },        // 14.072 thermal_conductivity
+    { 0x0E49, u"V/K" },         // 14.073 thermoelectric_power
+    { 0x0E4A, u"s" },           // 14.074 time_seconds
+    { 0x0E4B, u"Nm" },          // 14.075 torque
+    { 0x0E4C, u"m³" },          // 14.076 volume
+    { 0x0E4D, u"m³/s" },        // 14.077 volume_flux
+    { 0x0E4E, u"N" },           // 14.078 weight
+    { 0x0E4F, u"J" },           // 14.079 work
+    { 0x0E50, u"VA" },          // 14.080 apparent_power
+};
+
+static QString knxUnit(quint16 dpt)
 {
-    uint8_t major = type >> 8 & 0xFF;
-    uint8_t minor = type & 0xFF;
+    const auto *end = s_units + sizeof(s_units) / sizeof(s_units[0]);
+    const auto *it = std::lower_bound(s_units, end, dpt, [](const auto &entry, quint16 dpt) {
+        return entry.dpt < dpt;
+    });
+    if(it == end || it->dpt != dpt)
+        return QString();
+    return QString::fromRawData(reinterpret_cast<const QChar *>(it->unit), std::char_traits<char16_t>::length(it->unit));
+}
 
-    switch(major)
-    {
-    case 5: // 1byte_unsigned
-        {
-            switch(minor)
-            {
-                case 1: return "%"; // percent
-                case 3: return "°"; // angle
-                case 4: return "%"; // percentU8
-            }
-        }
-    break;
+KnxObject::KnxObject(const QString &name, quint16 gad, quint16 dpt, QObject *parent)
+    : KaZaObject{name, parent}
+    , m_gad(gad)
+    , m_dpt(dpt)
+    , m_codec(knxDptCodec(dpt))
+{
+    setUnit(knxUnit(m_dpt));
+}
+
+quint16 KnxObject::gad() const {
+    return m_gad;
+}
 
-    case 6: // 1byte_signed
+quint16 KnxObject::dpt() const {
+    return m_dpt;
+}
+
+const KnxDptCodec *KnxObject::codec() const {
+    return m_codec;
+}
+
+QVariant KnxObject::value() const {
+    _decodeDeferred();
+    if(!m_value.isValid())
     {
-        switch(minor)
-        {
-            case 1: return "%"; // percentV8
-        }
+        qCDebug(lcKnxValue) << "KnxObject ask read for " << name();
+        emit askRead(gad());
+        return QVariant();
     }
-    break;
+    return m_codec->toVariant(m_value);
+}
 
-    case 7: // 2byte_unsigned
+void KnxObject::setValue(QVariant newValue) {
+    qCDebug(lcKnxValue) << name() << " < " << newValue;
+    KnxValue value;
+    if(!_fromVariant(newValue, value))
+        return;
+    _decodeDeferred();
+    if(m_value != value)
     {
-        switch(minor)
-        {
-            case 2: return "ms"; // time_period_msec
-            case 3: return "ms"; // time_period_10msec
-            case 4: return "ms"; // time_period_100msec
-            case 5: return "s"; // time_period_sec
-            case 6: return "min"; // time_period_min
-            case 7: return "h"; // time_period_hrs
-            case 11: return "mm"; // time_period_msec
-            case 12: return "mA"; // current
-            case 13: return "lx"; // brightness
-        }
+        m_value = value;
+        emit valueChanged();
     }
-    break;
+}
 
-    case 8: // 2byte_signed
+void KnxObject::changeValue(QVariant newValue, bool confirm) {
+    /* Send KNX WRITE FRAME */
+    emit askWrite(gad(), dpt(), newValue);
+    if(confirm)
+        emit askConfirm(gad(), newValue);
+}
+
+const KnxValue &KnxObject::latestValue() const {
+    _decodeDeferred();
+    return m_pending.isValid() ? m_pending : m_value;
+}
+
+
+KnxObject::Update KnxObject::reciveFrame(unsigned char *buffer, int len) {
+    unsigned char cmd = static_cast<unsigned char>(((buffer[0] & 0x03) << 2) | ((buffer[1] & 0xC0) >> 6));
+
+    if((cmd == KNX_WRITE) | (cmd == KNX_RESPONSE))
     {
-        switch(minor)
+        if(!m_codec)
         {
-            case 2: return "ms"; // delta_time_ms
-            case 3: return "ms"; // delta_time_10ms
-            case 4: return "ms"; // delta_time_100ms
-            case 5: return "s"; // delta_time_sec
-            case 6: return "min"; // delta_time_min
-            case 7: return "h"; // delta_time_hrs
-            case 10: return "%"; // percentV16
-            case 11: return "°"; // rotation_angle
-            case 12: return "m"; // length_m
+            static bool first = true;
+            if(first)
+            {
+                qCWarning(lcKnxFrame) << "Not managed type " << dptToStr(m_dpt);
+                first = false;
+            }
+            return Unsupported;
         }
-    }
-    break;
 
-    case 9: // 2byte_float
-    {
-        switch(minor)
+        if(len < knxDptFrameSize(m_codec))
         {
-            case 1: return "°C"; // temperaturev
-            case 2: return "K";  // temperature_difference_2byte
-            case 3: return "K/h"; // temperature_a
-            case 4: return "Lux"; // illuminance
-            case 5: return "m/s"; // wind_speed_ms
-            case 6: return "Pa"; // pressure_2byte
-            case 7: return "%"; // humidity
-            case 8: return "ppm"; // ppm
-            case 9: return "m³/h"; // air_flow
-            case 10: return "s"; // time_1
-            case 11: return "ms"; // time_2
-            case 20: return "mV"; // voltage
-            case 21: return "mA"; // current
-            case 22: return "W/m²"; // power_density
-            case 23: return "K/%"; // kelvin_per_percent
-            case 24: return "kW"; // power_2byte
-            case 25: return "l/h"; // volume_flow
-            case 26: return "l/m²"; // rain_amount
-            case 27: return "°F"; // temperature_f
-            case 28: return "km/h"; // wind_speed_kmh
-            case 29: return "g/m³"; // absolute_humidity
-            case 30: return "μg/m³"; // concentration_ugm3
+            qCWarning(lcKnxFrame) << "INVALID TELEGRAM " << frameToStr(buffer, len) << "FOR DPT " << dptToStr(m_dpt);
+            return Invalid;
         }
-    }
-    break;
 
-    case 12: // 4byte_unsigned
-    {
-        switch(minor)
+        if(m_lazyDecode && m_observers == 0)
         {
-            case 100: return "s"; // long_time_period_sec
-            case 101: return "min"; // long_time_period_min
-            case 102: return "h"; // long_time_period_hrs
+            m_rawLen = static_cast<quint8>(knxDptFrameSize(m_codec) - 1);
+            memcpy(m_raw, buffer + 1, m_rawLen);
+            m_pending = KnxValue();
+            return Deferred;
         }
-    }
-    break;
+        /* Compare against the deferred value, if any */
+        _decodeDeferred();
 
-    case 13: // 4byte_signed
-    {
-        switch(minor)
+        KnxValue value;
+        m_codec->decode(buffer + 1, value);
+        qCDebug(lcKnxFrame).noquote() << "RECIVE " << ((cmd == KNX_WRITE)?("WRITE"):("RESPONSE")) << " FRAME FOR " << gadToStr(m_gad) << " (" << name() << ") set value to " << m_codec->toVariant(value);
+        return _update(value);
+    }
+    else {
+        if(m_localData)
         {
-            case 2: return "m³/h"; // flow_rate_m3h
-            case 10: return "Wh"; // active_energy
-            case 11: return "VAh"; // apparant_energy
-            case 12: return "VARh"; // reactive_energy
-            case 13: return "kWh"; // active_energy_kwh
-            case 14: return "kVAh"; // apparant_energy_kvah
-            case 15: return "kVARh"; // reactive_energy_kvarh
-            case 16: return "MWh"; // active_energy_mwh
-            case 100: return "s"; // long_delta_timesec
+            qCDebug(lcKnxFrame) << "TODO: Recieve READ FRAME on Local Data managed object";
         }
     }
-    break;
+    return Ignored;
+}
+
+KnxObject::Update KnxObject::reciveValue(const KnxValue &value) {
+    if(!m_codec)
+        return Unsupported;
+    _decodeDeferred();
+    return _update(value);
+}
 
-    case 14: // 4byte_float
+double KnxObject::deadband() const {
+    return m_deadband;
+}
+
+void KnxObject::setDeadband(double deadband) {
+    m_deadband = qMax(0.0, deadband);
+}
+
+int KnxObject::minInterval() const {
+    return m_minInterval;
+}
+
+void KnxObject::setMinInterval(int minInterval) {
+    m_minInterval = qMax(0, minInterval);
+    if(m_minInterval == 0 && m_throttle)
     {
-        switch(minor)
-        {
-        case 0: return "m/s²"; // acceleration
-        case 1: return "rad/s²"; // acceleration_angular
-        case 2: return "J/mol"; // activation_energy
-        case 3: return "s⁻¹"; // activity
-        case 4: return "mol"; // mol
-        case 6: return "rad"; // angle_rad
-        case 7: return "°"; // angle_deg
-        case 8: return "J s"; // angular_momentum
-        case 9: return "rad/s"; // angular_velocity
-        case 10: return "m²"; // area
-        case 11: return "F"; // capacitance
-        case 12: return "C/m²"; // charge_density_surface
-        case 13: return "C/m³"; // charge_density_volume
-        case 14: return "m²/N"; // compressibility
-        case 15: return "S"; // conductance
-        case 16: return "S/m"; // electrical_conductivity
-        case 17: return "kg/m³"; // density
-        case 18: return "C"; // electric_charge
-        case 19: return "A"; // electric_current
-        case 20: return "A/m²"; // electric_current_density
-        case 21: return "C m"; // electric_dipole_moment
-        case 22: return "C/m²"; // electric_displacement
-        case 23: return "V/m"; // electric_field_strength
-        case 24: return "c"; // electric_flux
-        case 25: return "C/m²"; // electric_flux_density
-        case 26: return "C/m²"; // electric_polarization
-        case 27: return "V"; // electric_potential
-        case 28: return "V"; // electric_potential_difference
-        case 29: return "A m²"; //  electromagnetic_moment
-        case 30: return "V"; // electromotive_force
-        case 31: return "J"; // energy
-        case 32: return "N"; // force
-        case 33: return "Hz"; // frequency
-        case 34: return "rad/s"; // angular_frequency
-        case 35: return "J/K"; // heatcapacity
-        case 36: return "W"; // heatflowrate
-        case 37: return "J"; // heat_quantity
-        case 38: return "Ω"; // impedance
-        case 39: return "m"; // length
-        case 40: return "lm s"; // light_quantity
-        case 41: return "cd/m²"; // luminance
-        case 42: return "lm"; // luminous_flux
-        case 43: return "cd"; // luminous_intensity
-        case 44: return "A/m"; // magnetic_field_strength
-        case 45: return "Wb"; // magnetic_flux
-        case 46: return "T"; // magnetic_flux_density
-        case 47: return "A m²"; // magnetic_moment
-        case 48: return "T"; // magnetic_polarization
-        case 49: return "A/m"; // magnetization
-        case 50: return "A"; // magnetomotive_force
-        case 51: return "kg"; // mass
-        case 52: return "kg/s"; // mass_flux
-        case 53: return "N/s"; // momentum
-        case 54: return "rad"; // phaseanglerad
-        case 55: return "°"; // phaseangledeg
-        case 56: return "W"; // power
-        case 58: return "Pa"; // pressure
-        case 59: return "Ω"; // reactance
-        case 60: return "Ω"; // resistance
-        case 61: return "Ωm"; // resistivity
-        case 62: return "H"; // self_inductance
-        case 63: return "sr"; // solid_angle
-        case 64: return "W/m²"; // sound_intensity
-        case 65: return "m/s"; // speed
-        case 66: return "Pa"; // stress
-        case 67: return "N/m"; // surface_tension
-        case 68: return "°C"; // common_temperature
-        case 69: return "K"; // absolute_temperature
-        case 70: return "K"; // temperature_difference
-        case 71: return "J/K"; // thermal_capacity
-        case 72: return "W/mK"; // thermal_conductivity
-        case 73: return "V/K"; // thermoelectric_power
-        case 74: return "s"; // time_seconds
-        case 75: return "Nm"; // torque
-        case 76: return "m³"; // volume
-        case 77: return "m³/s"; // volume_flux
-        case 78: return "N"; // weight
-        case 79: return "J"; // work
-        case 80: return "VA"; // apparent_power
-        }
-    }
-    break;
+        m_throttle->stop();
+        _flushPending();
     }
-    return "";
 }
 
-KnxObject::KnxObject(const QString &name, quint16 gad, quint16 dpt, QObject *parent)
-    : KaZaObject{name, parent}
-    , m_gad(gad)
-    , m_dpt(dpt)
-{
-    setUnit(getUnit(m_dpt));
+int KnxObject::observers() const {
+    return m_observers;
 }
 
-quint16 KnxObject::gad() const {
-    return m_gad;
+bool KnxObject::lazyDecode() const {
+    return m_lazyDecode;
 }
 
-quint16 KnxObject::dpt() const {
-    return m_dpt;
+void KnxObject::setLazyDecode(bool lazyDecode) {
+    m_lazyDecode = lazyDecode;
+    if(!m_lazyDecode)
+        _decodeDeferred();
 }
 
-QVariant KnxObject::value() const {
-    if(!m_value.isValid())
+void KnxObject::connectNotify(const QMetaMethod &signal)
+{
+    KaZaObject::connectNotify(signal);
+    if(signal == QMetaMethod::fromSignal(&KnxObject::valueChanged))
+        _updateObservers();
+}
+
+void KnxObject::disconnectNotify(const QMetaMethod &signal)
+{
+    KaZaObject::disconnectNotify(signal);
+    /* The signal is invalid when everything is disconnected at once */
+    if(!signal.isValid() || signal == QMetaMethod::fromSignal(&KnxObject::valueChanged))
+        _updateObservers();
+}
+
+static inline double numeric(const KnxValue &value)
+{
+    switch(value.kind)
     {
-#ifdef DEBUG_KNX
-        qDebug() << "KnxObject ask read for " << name();
-#endif
-        emit askRead(gad());
+    case KnxValue::Int: return static_cast<double>(value.i);
+    case KnxValue::UInt: return static_cast<double>(value.u);
+    case KnxValue::Float: return value.f;
+    default: return 0.0;
     }
-    return m_value;
 }
 
-void KnxObject::setValue(QVariant newValue) {
-    qDebug() << name() << " < " << newValue;
-    if(m_value != newValue)
+KnxObject::Update KnxObject::_update(const KnxValue &value)
+{
+    /* While throttled, compare against the value that will be emitted */
+    const KnxValue &current = m_pending.isValid() ? m_pending : m_value;
+    if(value == current)
+        return Suppressed;
+
+    if(m_deadband > 0.0 && value.kind == m_value.kind
+        && (value.kind == KnxValue::Int || value.kind == KnxValue::UInt || value.kind == KnxValue::Float)
+        && qAbs(numeric(value) - numeric(m_value)) < m_deadband)
     {
-        m_value = newValue;
-        emit valueChanged();
+        m_pending = KnxValue();
+        return Suppressed;
     }
-}
 
-void KnxObject::changeValue(QVariant newValue, bool confirm) {
-    /* Send KNX WRITE FRAME */
-    emit askWrite(gad(), dpt(), newValue);
-    while(confirm)
+    if(m_minInterval > 0 && m_value.isValid())
     {
-        QTimer timeout;
-        QEventLoop wait;
-        QObject::connect(&timeout, &QTimer::timeout, &wait, &QEventLoop::quit);
-        QObject::connect(this, &KnxObject::valueChanged, &wait, &QEventLoop::quit);
-        emit askWrite(gad(), dpt(), QVariant());
-        timeout.start(500);
-        wait.exec();
-        if(timeout.remainingTime() == 0)
-        {
-            emit askWrite(gad(), dpt(), QVariant());
-        }
-        else
+        const qint64 elapsed = (knxTimestamp() - m_lastEmit) / 1000000;
+        if(elapsed < m_minInterval)
         {
-            if(m_value != newValue)
+            m_pending = value;
+            if(!m_throttle)
             {
-                emit askWrite(gad(), dpt(), newValue);
-                emit askWrite(gad(), dpt(), QVariant());
-            }
-            else {
-                break;
+                m_throttle = new QTimer(this);
+                m_throttle->setSingleShot(true);
+                QObject::connect(m_throttle, &QTimer::timeout, this, &KnxObject::_flushPending);
             }
+            if(!m_throttle->isActive())
+                m_throttle->start(static_cast<int>(m_minInterval - elapsed));
+            return Throttled;
         }
     }
+
+    m_pending = KnxValue();
+    m_value = value;
+    m_lastEmit = knxTimestamp();
+    emit valueChanged();
+    return Propagated;
 }
 
+void KnxObject::_flushPending()
+{
+    if(!m_pending.isValid())
+        return;
+    m_value = m_pending;
+    m_pending = KnxValue();
+    m_lastEmit = knxTimestamp();
+    emit valueChanged();
+}
 
-void KnxObject::reciveFrame(unsigned char *buffer, int len) {
-    unsigned char cmd = static_cast<unsigned char>(((buffer[0] & 0x03) << 2) | ((buffer[1] & 0xC0) >> 6));
+void KnxObject::_decodeDeferred() const
+{
+    if(m_rawLen == 0)
+        return;
+    KnxValue value;
+    m_codec->decode(m_raw, value);
+    m_value = value;
+    m_rawLen = 0;
+}
 
-    if((cmd == KNX_WRITE) | (cmd == KNX_RESPONSE))
+void KnxObject::_updateObservers()
+{
+    /* receivers() also counts the QML bindings */
+    const int observers = receivers(SIGNAL(valueChanged()));
+    const bool observed = observers > 0;
+    const bool changed = observed != (m_observers > 0);
+    m_observers = observers;
+    if(changed)
     {
-        uint8_t mdpt = (m_dpt >> 8);
-
-        if(len < 2)
-        {
-            qWarning() << "INVALID TELEGRAM " << frameToStr(buffer, len) << "FOR DPT " << dptToStr(m_dpt);
-            return;
-        }
+        /* A new observer reads the current value */
+        if(observed)
+            _decodeDeferred();
+        emit observedChanged(observed);
+    }
+}
 
-        switch(mdpt)
-        {
-            case 1:
-            {
-                m_value.setValue<bool>(buffer[1] & 0x1);
-                emit valueChanged();
-                break;
-            }
-            case 5:
-            {
-                if(len < 3)
-                {
-                    qWarning() << "INVALID TELEGRAM " << frameToStr(buffer, len) << "FOR DPT " << dptToStr(m_dpt);
-                    return;
-                }
-                unsigned char d0 = (unsigned char)(buffer[2]);
-                unsigned short v = d0; // Short instead of char to avoid toString conversion error
-
-                switch(m_dpt & 0xFF)
-                {
-                    case 1: // DPT_Scaling [0...100]
-                        v = ((d0 * 100) / 255);
-                        break;
-                    case 2: // DPT_Angle [0...360]
-                        v = ((d0 * 360) / 255);
-                        break;
-                    default:
-                        break;
-                }
-
-                m_value.setValue(v);
-                emit valueChanged();
-                break;
-            }
-            case 7:
-            {
-                if(len < 4)
-                {
-                    qWarning() << "INVALID TELEGRAM " << frameToStr(buffer, len) << "FOR DPT " << dptToStr(m_dpt);
-                    return;
-                }
-                unsigned char d0 = (unsigned char)(buffer[2]);
-                unsigned char d1 = (unsigned char)(buffer[3]);
-                unsigned short v = d0 << 8 | d1;
-                m_value.setValue(v);
-                emit valueChanged();
-                break;
-            }
-            case 9:
-            {
-                if(len < 4)
-                {
-                    qWarning() << "INVALID TELEGRAM " << frameToStr(buffer, len) << "FOR DPT " << dptToStr(m_dpt);
-                    return;
-                }
-                unsigned char d0 = (unsigned char)(buffer[2]);
-                unsigned char d1 = (unsigned char)(buffer[3]);
-                unsigned char sign = (d0 & 0x80) >>  7;
-                unsigned short exp = (d0 & 0x78) >> 3;
-                int mant = ((d0 & 0x07) << 8) | d1;
-                if(sign != 0)
-                    mant = -(~(mant - 1) & 0x07ff);
-                m_value.setValue<float>((1 << exp) * 0.01 * ((int)mant));
-                emit valueChanged();
-                break;
-            }
-            case 13:
-            {
-                if(len < 6)
-                {
-                    qWarning() << "INVALID TELEGRAM " << frameToStr(buffer, len) << "FOR DPT " << dptToStr(m_dpt);
-                    return;
-                }
-                unsigned char d0 = (unsigned char)(buffer[2]);
-                unsigned char d1 = (unsigned char)(buffer[3]);
-                unsigned char d2 = (unsigned char)(buffer[4]);
-                unsigned char d3 = (unsigned char)(buffer[5]);
-                signed int v = d0 << 24 | d1 << 16 | d2 << 8 | d3;
-                m_value.setValue(v);
-                emit valueChanged();
-                break;
-            }
-            case 14:
-            {
-                if(len < 6)
-                {
-                    qWarning() << "INVALID TELEGRAM " << frameToStr(buffer, len) << "FOR DPT " << dptToStr(m_dpt);
-                    return;
-                }
-                float v;
-                unsigned int rdata = (((unsigned char)(buffer[2])<< 24) |
-                                      ((unsigned char)(buffer[3])<< 16) |
-                                      ((unsigned char)(buffer[4])<< 8) |
-                                      (unsigned char)(buffer[5]));
-                memcpy(&v, &rdata, 4);
-                m_value.setValue(v);
-                emit valueChanged();
-                break;
-            }
-            case 20:
-            {
-                if(len < 3)
-                {
-                    qWarning() << "INVALID TELEGRAM " << frameToStr(buffer, len) << "FOR DPT " << dptToStr(m_dpt);
-                    return;
-                }
-                unsigned char d0 = (unsigned char)(buffer[2]);
-                m_value.setValue(d0);
-                emit valueChanged();
-                break;
-            }
-            default:
-            {
-                static bool first = true;
-                if(first)
-                {
-                    qWarning() << "Not managed type " << dptToStr(m_dpt);
-                    first = false;
-                }
-            }
-        }
-#ifdef DEBUG_KNX_FRAME
-        qDebug().noquote() << "RECIVE " << ((cmd == KNX_WRITE)?("WRITE"):("RESPONSE")) << " FRAME FOR " << gadToStr(m_gad) << " (" << name() << ") set value to " << m_value;
-#endif
+bool KnxObject::_fromVariant(const QVariant &variant, KnxValue &value) const
+{
+    if(!m_codec)
+    {
+        if(variant.isValid())
+            qWarning() << "Not managed type " << dptToStr(m_dpt) << "for" << name();
+        return !variant.isValid();
     }
-    else {
-        if(m_localData)
-        {
-            qDebug() << "TODO: Recieve READ FRAME on Local Data managed object";
-        }
+    if(!knxDptFromVariant(m_codec, variant, value))
+    {
+        qWarning() << "Can't convert" << variant << "to DPT" << dptToStr(m_dpt) << "for" << name();
+        return false;
     }
+    return true;
 }
 
 QVariant KnxObject::rawid() const
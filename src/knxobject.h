@@ -3,6 +3,9 @@
 
 #include <kazaobject.h>
 #include <QVariant>
+#include "knxdpt.h"
+
+class QTimer;
 
 class KnxObject : public KaZaObject
 {
@@ -13,31 +16,88 @@ public:
 
     quint16 gad() const;
     quint16 dpt() const;
+    const KnxDptCodec *codec() const;
 
     QVariant value() const override;
     void setValue(QVariant newValue) override;
     void changeValue(QVariant, bool confirm = false) override;
 
-    void reciveFrame(unsigned char *buffer, int len);
+    enum Update {
+        Ignored,        // Not a value telegram
+        Invalid,        // Payload not decodable for the DPT
+        Unsupported,    // Value telegram on an object whose DPT has no codec
+        Propagated,     // valueChanged emitted
+        Suppressed,     // Same value, or change within the deadband
+        Throttled,      // Delayed by the minimum interval, emitted later
+        Deferred        // Kept raw until read, nobody observes the object
+    };
+
+    Update reciveFrame(unsigned char *buffer, int len);
+    /* Same as reciveFrame() for a value telegram already decoded, by the
+     * batched float kernels for instance */
+    Update reciveValue(const KnxValue &value);
+
+    /* Last decoded value, including one still held back by minInterval */
+    const KnxValue &latestValue() const;
+
+    /* Changes smaller than deadband are not propagated, 0 propagates any change */
+    double deadband() const;
+    void setDeadband(double deadband);
+
+    /* Minimum time between two valueChanged, last value wins */
+    int minInterval() const;
+    void setMinInterval(int minInterval);
+
+    /* Connections to valueChanged, QML bindings included */
+    int observers() const;
+
+    /* When set, values received while nobody observes the object are kept
+     * raw and only decoded when read or when an observer connects */
+    bool lazyDecode() const;
+    void setLazyDecode(bool lazyDecode);
 
     QVariant rawid() const override;
 
+protected:
+    void connectNotify(const QMetaMethod &signal) override;
+    void disconnectNotify(const QMetaMethod &signal) override;
+
 private:
     quint16 m_gad;
     quint16 m_dpt;
-    QVariant m_value;
+    const KnxDptCodec *m_codec;
+    /* Decoded from m_raw on first access in lazy mode */
+    mutable KnxValue m_value;
+    mutable quint8 m_rawLen {0};
+    unsigned char m_raw[1 + KNX_DPT_MAX_SIZE];
+    int m_observers {0};
+    bool m_lazyDecode {false};
     bool m_localData {false};
+    double m_deadband {0.0};
+    int m_minInterval {0};
+    qint64 m_lastEmit {0};
+    KnxValue m_pending;
+    QTimer *m_throttle {nullptr};
+
+    bool _fromVariant(const QVariant &variant, KnxValue &value) const;
+    Update _update(const KnxValue &value);
+    void _flushPending();
+    void _decodeDeferred() const;
+    void _updateObservers();
 
 
 signals:
     void askRead(quint16 gad) const;
     void askWrite(quint16 gad, quint16 dpt, QVariant value) const;
+    void askConfirm(quint16 gad, QVariant value) const;
+    void writeConfirmed(bool confirmed);
+    void observedChanged(bool observed);
 
 };
 
 static inline QString addrToStr(uint16_t addr)
 {
-    return QString("%1.%2.%3").arg((addr >> 11) & 0x1f).arg((addr >> 8) & 0x07).arg((addr) & 0xff);
+    return QString("%1.%2.%3").arg((addr >> 12) & 0x0f).arg((addr >> 8) & 0x0f).arg((addr) & 0xff);
 }
 
 static inline QString gadToStr(uint16_t addr)
@@ -45,6 +105,36 @@ static inline QString gadToStr(uint16_t addr)
     return QString("%1/%2/%3").arg((addr >> 11) & 0x1f).arg((addr >> 8) & 0x07).arg((addr) & 0xff);
 }
 
+/* Parse a "main/middle/sub" group address, return -1 if invalid */
+static inline int strToGad(const QString &str)
+{
+    const QStringList parts = str.split('/');
+    if(parts.size() != 3)
+        return -1;
+    bool ok[3];
+    int main = parts[0].toInt(&ok[0]);
+    int middle = parts[1].toInt(&ok[1]);
+    int sub = parts[2].toInt(&ok[2]);
+    if(!ok[0] || !ok[1] || !ok[2] || main < 0 || main > 0x1f || middle < 0 || middle > 0x07 || sub < 0 || sub > 0xff)
+        return -1;
+    return (main << 11) | (middle << 8) | sub;
+}
+
+/* Parse an "area.line.device" individual address, return -1 if invalid */
+static inline int strToAddr(const QString &str)
+{
+    const QStringList parts = str.split('.');
+    if(parts.size() != 3)
+        return -1;
+    bool ok[3];
+    int area = parts[0].toInt(&ok[0]);
+    int line = parts[1].toInt(&ok[1]);
+    int device = parts[2].toInt(&ok[2]);
+    if(!ok[0] || !ok[1] || !ok[2] || area < 0 || area > 0x0f || line < 0 || line > 0x0f || device < 0 || device > 0xff)
+        return -1;
+    return (area << 12) | (line << 8) | device;
+}
+
 static inline QString dptToStr(uint16_t d)
 {
     return QString("%1.%2").arg((d >> 8) & 0xff).arg(d & 0xff);
@@ -0,0 +1,362 @@
+#include "knxprojreader.h"
+#include <QHash>
+#include <QIODevice>
+#include <QRegularExpression>
+#include <QSet>
+#include <QThreadPool>
+#include <QXmlStreamReader>
+#include <minizip/unzip.h>
+#include <algorithm>
+
+/* Sequential QIODevice over the current entry of a minizip archive */
+class KnxZipEntryDevice : public QIODevice
+{
+public:
+    explicit KnxZipEntryDevice(unzFile zip)
+        : m_zip(zip)
+    {
+    }
+
+    bool isSequential() const override {
+        return true;
+    }
+
+    /* Uncompressed bytes inflated so far */
+    quint64 total() const {
+        return m_total;
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override {
+        int len = unzReadCurrentFile(m_zip, data, static_cast<unsigned>(qMin<qint64>(maxSize, 64 * 1024)));
+        if(len < 0)
+        {
+            setErrorString(QStringLiteral("Inflate error %1").arg(len));
+            return -1;
+        }
+        m_total += len;
+        return len;
+    }
+
+    qint64 writeData(const char *, qint64) override {
+        return -1;
+    }
+
+private:
+    unzFile m_zip;
+    quint64 m_total {0};
+};
+
+/* Inflate one entry with a private zip handle and hand it to parse().
+ * The entry is always read to its end: minizip only checks the CRC there. */
+template<typename Parse>
+static QString inflateEntry(const QString &path, quint64 directoryOffset, quint64 fileNumber, quint64 size,
+                            const QString &name, Parse parse)
+{
+    unzFile zip = unzOpen64(path.toStdString().c_str());
+    if(zip == NULL)
+        return QStringLiteral("Can't open %1").arg(path);
+
+    unz64_file_pos pos;
+    pos.pos_in_zip_directory = directoryOffset;
+    pos.num_of_file = fileNumber;
+    if(unzGoToFilePos64(zip, &pos) != UNZ_OK || unzOpenCurrentFile(zip) != UNZ_OK)
+    {
+        unzClose(zip);
+        return QStringLiteral("Can't inflate %1 of %2").arg(name, path);
+    }
+
+    QString error;
+    KnxZipEntryDevice device(zip);
+    device.open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    QXmlStreamReader xml(&device);
+    parse(xml);
+    if(xml.hasError())
+        error = QStringLiteral("XML error in %1 of %2: %3").arg(name, path, xml.errorString());
+
+    QByteArray rest(64 * 1024, Qt::Uninitialized);
+    while(device.read(rest.data(), rest.size()) > 0)
+    {
+    }
+    device.close();
+
+    if(unzCloseCurrentFile(zip) == UNZ_CRCERROR)
+        error = QStringLiteral("CRC mismatch in %1 of %2").arg(name, path);
+    else if(error.isEmpty() && device.total() != size)
+        error = QStringLiteral("%1 of %2 truncated (%3 of %4 bytes)").arg(name, path).arg(device.total()).arg(size);
+    unzClose(zip);
+    return error;
+}
+
+/* Move to the next child element named name, skipping the other subtrees */
+static bool enterElement(QXmlStreamReader &xml, QStringView name)
+{
+    while(xml.readNextStartElement())
+    {
+        if(xml.name() == name)
+            return true;
+        xml.skipCurrentElement();
+    }
+    return false;
+}
+
+/* Group addresses are referenced as "P-0123-0_GA-1" or "GA-1" */
+static QString groupAddressKey(QStringView id)
+{
+    return id.mid(id.lastIndexOf('_') + 1).toString();
+}
+
+static void readGroupRanges(QXmlStreamReader &xml, QStringList &path, QList<KnxProjReader::GroupAddress> &out, QStringList &ids)
+{
+    while(xml.readNextStartElement())
+    {
+        if(xml.name() == QLatin1String("GroupRange"))
+        {
+            path.append(xml.attributes().value(QLatin1String("Name")).trimmed().toString());
+            readGroupRanges(xml, path, out, ids);
+            path.removeLast();
+        }
+        else if(xml.name() == QLatin1String("GroupAddress"))
+        {
+            const QXmlStreamAttributes attrs = xml.attributes();
+            KnxProjReader::GroupAddress ga;
+            ga.range = path.join('.');
+            ga.name = attrs.value(QLatin1String("Name")).trimmed().toString();
+            ga.gad = static_cast<quint16>(attrs.value(QLatin1String("Address")).toInt());
+            ga.datapointType = attrs.value(QLatin1String("DatapointType")).toString();
+            ga.installation = 0;
+            ga.links = 0;
+            out.append(ga);
+            ids.append(groupAddressKey(attrs.value(QLatin1String("Id"))));
+            xml.skipCurrentElement();
+        }
+        else
+        {
+            xml.skipCurrentElement();
+        }
+    }
+}
+
+/* Count the comm objects linked to each group address in the Topology subtree:
+ * ETS 6 lists them in ComObjectInstanceRef/@Links, older versions in
+ * Connectors/Send|Receive/@GroupAddressRefId */
+static void readLinks(QXmlStreamReader &xml, QHash<QString, int> &links)
+{
+    int depth = 0;
+    while(!xml.atEnd())
+    {
+        switch(xml.readNext())
+        {
+        case QXmlStreamReader::StartElement:
+            depth++;
+            if(xml.name() == QLatin1String("ComObjectInstanceRef"))
+            {
+                const QStringView refs = xml.attributes().value(QLatin1String("Links"));
+                for(QStringView ref: refs.split(' ', Qt::SkipEmptyParts))
+                    links[groupAddressKey(ref)]++;
+            }
+            else if(xml.name() == QLatin1String("Send") || xml.name() == QLatin1String("Receive"))
+            {
+                const QStringView ref = xml.attributes().value(QLatin1String("GroupAddressRefId"));
+                if(!ref.isEmpty())
+                    links[groupAddressKey(ref)]++;
+            }
+            break;
+        case QXmlStreamReader::EndElement:
+            if(depth-- == 0)
+                return;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+KnxProjReader::KnxProjReader(const QString &path)
+    : m_path(path)
+{
+}
+
+bool KnxProjReader::read()
+{
+    m_groupAddresses.clear();
+    m_projectName.clear();
+    m_installations.clear();
+    m_hasTopology = false;
+    m_error.clear();
+
+    QList<ZipEntry> entries;
+    if(!_index(entries))
+        return false;
+
+    static const QRegularExpression installationFile(QStringLiteral("^[^/]+/(\\d+)\\.xml$"));
+    static const QRegularExpression projectFile(QStringLiteral("^[^/]+/project\\.xml$"), QRegularExpression::CaseInsensitiveOption);
+
+    const ZipEntry *project = nullptr;
+    QList<QPair<int, const ZipEntry *>> installations;
+    for(const ZipEntry &entry: std::as_const(entries))
+    {
+        const QRegularExpressionMatch match = installationFile.match(entry.name);
+        if(match.hasMatch())
+            installations.append({match.captured(1).toInt(), &entry});
+        else if(!project && projectFile.match(entry.name).hasMatch())
+            project = &entry;
+    }
+    if(installations.isEmpty())
+    {
+        m_error = QStringLiteral("No installation found in %1").arg(m_path);
+        return false;
+    }
+    std::sort(installations.begin(), installations.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+
+    /* Every task fills its own slot, nothing is shared between workers */
+    struct Installation {
+        QString name;
+        QList<GroupAddress> addresses;
+        QStringList ids;
+        QHash<QString, int> links;
+        QString error;
+    };
+    QList<Installation> results(installations.size());
+    QString projectError;
+
+    QThreadPool pool;
+    if(project)
+    {
+        pool.start([this, project, &projectError]() {
+            projectError = inflateEntry(m_path, project->directoryOffset, project->fileNumber, project->size, project->name,
+                                        [this](QXmlStreamReader &xml) {
+                if(enterElement(xml, u"KNX") && enterElement(xml, u"Project") && enterElement(xml, u"ProjectInformation"))
+                    m_projectName = xml.attributes().value(QLatin1String("Name")).trimmed().toString();
+            });
+        });
+    }
+    for(int i = 0; i < installations.size(); i++)
+    {
+        const ZipEntry *entry = installations[i].second;
+        Installation *result = &results[i];
+        pool.start([this, entry, result]() {
+            result->error = inflateEntry(m_path, entry->directoryOffset, entry->fileNumber, entry->size, entry->name,
+                                         [result](QXmlStreamReader &xml) {
+                if(!enterElement(xml, u"KNX") || !enterElement(xml, u"Project")
+                    || !enterElement(xml, u"Installations") || !enterElement(xml, u"Installation"))
+                    return;
+
+                /* Topology and GroupAddresses are siblings, both read in the same walk */
+                result->name = xml.attributes().value(QLatin1String("Name")).trimmed().toString();
+                while(xml.readNextStartElement())
+                {
+                    if(xml.name() == QLatin1String("Topology"))
+                    {
+                        readLinks(xml, result->links);
+                    }
+                    else if(xml.name() == QLatin1String("GroupAddresses"))
+                    {
+                        if(enterElement(xml, u"GroupRanges"))
+                        {
+                            QStringList path;
+                            readGroupRanges(xml, path, result->addresses, result->ids);
+                            xml.skipCurrentElement();
+                        }
+                    }
+                    else
+                    {
+                        xml.skipCurrentElement();
+                    }
+                }
+            });
+        });
+    }
+    pool.waitForDone();
+
+    /* Merge in installation order, the first installation owning an address wins */
+    QStringList errors;
+    if(!projectError.isEmpty())
+        errors.append(projectError);
+    QSet<quint16> seen;
+    int duplicates = 0;
+    for(int i = 0; i < results.size(); i++)
+    {
+        const Installation &result = results[i];
+        if(!result.error.isEmpty())
+            errors.append(result.error);
+        m_installations.append(result.name);
+        m_hasTopology |= !result.links.isEmpty();
+
+        for(int j = 0; j < result.addresses.size(); j++)
+        {
+            GroupAddress ga = result.addresses[j];
+            if(results.size() > 1)
+            {
+                if(seen.contains(ga.gad))
+                {
+                    duplicates++;
+                    continue;
+                }
+                seen.insert(ga.gad);
+            }
+            ga.installation = static_cast<quint8>(qMin(i, 0xFF));
+            ga.links = static_cast<quint16>(qMin(result.links.value(result.ids[j]), 0xFFFF));
+            m_groupAddresses.append(ga);
+        }
+    }
+    if(duplicates > 0)
+        errors.append(QStringLiteral("%1 group addresses defined in several installations of %2, first one kept").arg(duplicates).arg(m_path));
+
+    m_error = errors.join('\n');
+    return errors.isEmpty();
+}
+
+bool KnxProjReader::_index(QList<ZipEntry> &entries)
+{
+    unzFile zip = unzOpen64(m_path.toStdString().c_str());
+    if (zip == NULL) {
+        m_error = QStringLiteral("Can't open %1").arg(m_path);
+        return false;
+    }
+
+    int ret = unzGoToFirstFile(zip);
+    while(ret == UNZ_OK)
+    {
+        char fn[512];
+        unz_file_info64 info;
+        unz64_file_pos pos;
+        if(unzGetCurrentFileInfo64(zip, &info, fn, sizeof(fn), NULL, 0, NULL, 0) == UNZ_OK
+            && !(info.external_fa & (1 << 4))
+            && unzGetFilePos64(zip, &pos) == UNZ_OK)
+        {
+            entries.append({QString::fromUtf8(fn), pos.pos_in_zip_directory, pos.num_of_file, info.uncompressed_size});
+        }
+        ret = unzGoToNextFile(zip);
+    }
+    unzClose(zip);
+
+    if(ret != UNZ_END_OF_LIST_OF_FILE)
+    {
+        m_error = QStringLiteral("Corrupted zip directory in %1").arg(m_path);
+        return false;
+    }
+    return true;
+}
+
+const QList<KnxProjReader::GroupAddress> &KnxProjReader::groupAddresses() const {
+    return m_groupAddresses;
+}
+
+QString KnxProjReader::projectName() const {
+    return m_projectName;
+}
+
+const QStringList &KnxProjReader::installations() const {
+    return m_installations;
+}
+
+bool KnxProjReader::hasTopology() const {
+    return m_hasTopology;
+}
+
+QString KnxProjReader::errorString() const {
+    return m_error;
+}
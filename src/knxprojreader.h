@@ -0,0 +1,58 @@
+#ifndef KNXPROJREADER_H
+#define KNXPROJREADER_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/* Streaming reader of the group addresses of an ETS .knxproj archive.
+ *
+ * The zip central directory is indexed once, then the entries needed are
+ * inflated in parallel on a thread pool, each worker with its own zip
+ * handle: the project metadata (project.xml), and for every installation
+ * (<n>.xml) the group addresses and the comm object links of the
+ * topology, read in a single pass. Every entry is inflated to its end so
+ * its size and CRC are checked. The XML is parsed by chunks with a
+ * QXmlStreamReader, only the elements needed are materialized. */
+class KnxProjReader
+{
+public:
+    struct GroupAddress {
+        QString range;
+        QString name;
+        quint16 gad;
+        QString datapointType;
+        quint8 installation;
+        quint16 links;          // Comm objects linked in the topology
+    };
+
+    explicit KnxProjReader(const QString &path);
+
+    bool read();
+
+    const QList<GroupAddress> &groupAddresses() const;
+    QString projectName() const;
+    const QStringList &installations() const;
+    /* True if the topology holds comm object links, so links is meaningful */
+    bool hasTopology() const;
+    QString errorString() const;
+
+private:
+    struct ZipEntry {
+        QString name;
+        quint64 directoryOffset;
+        quint64 fileNumber;
+        quint64 size;
+    };
+
+    QString m_path;
+    QList<GroupAddress> m_groupAddresses;
+    QString m_projectName;
+    QStringList m_installations;
+    bool m_hasTopology {false};
+    QString m_error;
+
+    bool _index(QList<ZipEntry> &entries);
+};
+
+#endif // KNXPROJREADER_H
@@ -0,0 +1,101 @@
+#include "knxreadmanager.h"
+
+KnxReadManager::KnxReadManager(QObject *parent)
+    : QObject{parent}
+{
+    m_clock.start();
+    m_expire.setInterval(250);
+    QObject::connect(&m_expire, &QTimer::timeout, this, &KnxReadManager::_expire);
+}
+
+int KnxReadManager::cooldown() const {
+    return m_cooldown;
+}
+
+void KnxReadManager::setCooldown(int cooldown) {
+    m_cooldown = qMax(0, cooldown);
+}
+
+bool KnxReadManager::read(quint16 gad, Callback done)
+{
+    m_requested++;
+    const qint64 now = m_clock.elapsed();
+
+    auto it = m_entries.find(gad);
+    if(it != m_entries.end() && now - it->sent < m_cooldown)
+    {
+        if(done)
+        {
+            if(it->answered)
+                done(true);
+            else
+                it->waiters.append(std::move(done));
+        }
+        return false;
+    }
+
+    if(it == m_entries.end())
+        it = m_entries.insert(gad, Entry());
+    it->sent = now;
+    it->answered = false;
+    if(done)
+        it->waiters.append(std::move(done));
+    m_sent++;
+    if(!m_expire.isActive())
+        m_expire.start();
+    emit sendRead(gad);
+    return true;
+}
+
+void KnxReadManager::valueReceived(quint16 gad)
+{
+    auto it = m_entries.find(gad);
+    if(it == m_entries.end() || it->answered)
+        return;
+    it->answered = true;
+    const QList<Callback> waiters = std::move(it->waiters);
+    it->waiters.clear();
+    for(const Callback &done: waiters)
+        done(true);
+}
+
+void KnxReadManager::invalidate(quint16 gad)
+{
+    auto it = m_entries.find(gad);
+    if(it != m_entries.end())
+        it->sent = m_clock.elapsed() - m_cooldown;
+}
+
+quint64 KnxReadManager::requested() const {
+    return m_requested;
+}
+
+quint64 KnxReadManager::sent() const {
+    return m_sent;
+}
+
+quint64 KnxReadManager::saved() const {
+    return m_requested - m_sent;
+}
+
+void KnxReadManager::_expire()
+{
+    const qint64 now = m_clock.elapsed();
+    QList<Callback> failed;
+    for(auto it = m_entries.begin(); it != m_entries.end();)
+    {
+        if(now - it->sent < m_cooldown)
+        {
+            ++it;
+            continue;
+        }
+        failed.append(it->waiters);
+        it = m_entries.erase(it);
+    }
+    if(m_entries.isEmpty())
+        m_expire.stop();
+
+    /* Callbacks may issue new reads: run them once the table is consistent */
+    for(const Callback &done: std::as_const(failed))
+        done(false);
+}
@@ -0,0 +1,60 @@
+#ifndef KNXREADMANAGER_H
+#define KNXREADMANAGER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <functional>
+
+/* Deduplication of GroupValueRead requests.
+ *
+ * Every read goes through read(): a group address gets at most one read
+ * telegram per cooldown period, later requests are merged into the one in
+ * flight and their callbacks are completed when the response (or any
+ * write) arrives, or failed when the cooldown expires without answer. */
+class KnxReadManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<void(bool)> Callback;
+
+    explicit KnxReadManager(QObject *parent = nullptr);
+
+    int cooldown() const;
+    void setCooldown(int cooldown);
+
+    /* Return true if a read telegram was sent, false if merged */
+    bool read(quint16 gad, Callback done = Callback());
+    void valueReceived(quint16 gad);
+
+    /* Forget the last read of gad, the next read() sends a new telegram */
+    void invalidate(quint16 gad);
+
+    quint64 requested() const;
+    quint64 sent() const;
+    quint64 saved() const;
+
+signals:
+    void sendRead(quint16 gad);
+
+private:
+    struct Entry {
+        qint64 sent {0};
+        bool answered {false};
+        QList<Callback> waiters;
+    };
+
+    QTimer m_expire;
+    QElapsedTimer m_clock;
+    QHash<quint16, Entry> m_entries;
+    int m_cooldown {1000};
+    quint64 m_requested {0};
+    quint64 m_sent {0};
+
+    void _expire();
+};
+
+#endif // KNXREADMANAGER_H
@@ -0,0 +1,157 @@
+#include "knxreadscheduler.h"
+
+KnxReadScheduler::KnxReadScheduler(QObject *parent)
+    : QObject{parent}
+{
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(1000 / m_rate);
+    QObject::connect(&m_timer, &QTimer::timeout, this, &KnxReadScheduler::_tick);
+}
+
+int KnxReadScheduler::rate() const {
+    return m_rate;
+}
+
+void KnxReadScheduler::setRate(int telegramsPerSecond) {
+    m_rate = qBound(1, telegramsPerSecond, 1000);
+    m_timer.setInterval(qMax(1, 1000 / m_rate));
+}
+
+int KnxReadScheduler::maxAttempts() const {
+    return m_maxAttempts;
+}
+
+void KnxReadScheduler::setMaxAttempts(int maxAttempts) {
+    m_maxAttempts = qMax(1, maxAttempts);
+}
+
+void KnxReadScheduler::enqueue(quint16 gad)
+{
+    if(m_queued.contains(gad) || m_inflight.contains(gad))
+        return;
+    m_queued.insert(gad);
+    m_queue.enqueue(gad);
+    if(m_duration >= 0)
+    {
+        /* New work after completion: measure a new run on next start */
+        m_duration = -1;
+    }
+}
+
+void KnxReadScheduler::cancel(quint16 gad)
+{
+    m_queued.remove(gad);
+    m_inflight.remove(gad);
+}
+
+void KnxReadScheduler::responseReceived(quint16 gad)
+{
+    if(m_queued.isEmpty() && m_inflight.isEmpty())
+        return;
+    cancel(gad);
+    _checkFinished();
+}
+
+int KnxReadScheduler::pending() const {
+    return m_queued.size() + m_inflight.size();
+}
+
+bool KnxReadScheduler::isRunning() const {
+    return m_timer.isActive();
+}
+
+qint64 KnxReadScheduler::duration() const {
+    return m_duration;
+}
+
+void KnxReadScheduler::start()
+{
+    if(m_timer.isActive())
+        return;
+    m_clock.start();
+    /* Resumed after stop(): reads sent meanwhile may have been lost with
+     * the link, send them again without counting an attempt */
+    for(Entry &entry: m_inflight)
+    {
+        if(entry.sent)
+            entry.attempts--;
+        entry.sent = false;
+        entry.due = 0;
+    }
+    m_lastRefill = 0;
+    m_tokens = 1;
+    m_timer.start();
+    _tick();
+}
+
+void KnxReadScheduler::stop()
+{
+    m_timer.stop();
+}
+
+void KnxReadScheduler::_tick()
+{
+    const qint64 now = m_clock.elapsed();
+
+    /* Refill the bucket, allow a small burst of a quarter of a second */
+    const double burst = qMax(1.0, m_rate / 4.0);
+    m_tokens = qMin(burst, m_tokens + (now - m_lastRefill) * m_rate / 1000.0);
+    m_lastRefill = now;
+
+    /* Retries first: they are the oldest requests */
+    for(auto it = m_inflight.begin(); it != m_inflight.end();)
+    {
+        Entry &entry = it.value();
+        if(entry.due > now)
+        {
+            ++it;
+            continue;
+        }
+        if(entry.sent)
+        {
+            if(entry.attempts >= m_maxAttempts)
+            {
+                quint16 gad = it.key();
+                it = m_inflight.erase(it);
+                emit noResponse(gad);
+                continue;
+            }
+            entry.sent = false;
+            entry.due = now + (static_cast<qint64>(m_backoff) << (entry.attempts - 1));
+        }
+        else if(m_tokens >= 1.0)
+        {
+            m_tokens -= 1.0;
+            entry.sent = true;
+            entry.attempts++;
+            entry.due = now + m_responseTimeout;
+            emit sendRead(it.key());
+        }
+        ++it;
+    }
+
+    while(m_tokens >= 1.0 && !m_queue.isEmpty())
+    {
+        quint16 gad = m_queue.dequeue();
+        if(!m_queued.remove(gad))
+            continue; // Cancelled while queued
+        m_tokens -= 1.0;
+        Entry &entry = m_inflight[gad];
+        entry.sent = true;
+        entry.attempts = 1;
+        entry.due = now + m_responseTimeout;
+        emit sendRead(gad);
+    }
+
+    _checkFinished();
+}
+
+void KnxReadScheduler::_checkFinished()
+{
+    if(!m_timer.isActive() || !m_queued.isEmpty() || !m_inflight.isEmpty())
+        return;
+    m_timer.stop();
+    m_queue.clear();
+    m_duration = m_clock.elapsed();
+    emit finished(m_duration);
+}
@@ -0,0 +1,74 @@
+#ifndef KNXREADSCHEDULER_H
+#define KNXREADSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QQueue>
+#include <QHash>
+#include <QSet>
+
+/* Paced GroupValueRead scheduler used to populate the object model.
+ *
+ * Reads are sent at most at rate() telegrams per second (token bucket), an
+ * address without response is retried with an exponential backoff and
+ * dropped after maxAttempts(). Nothing here blocks: everything is driven
+ * by a timer of the owner thread. */
+class KnxReadScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KnxReadScheduler(QObject *parent = nullptr);
+
+    int rate() const;
+    void setRate(int telegramsPerSecond);
+
+    int maxAttempts() const;
+    void setMaxAttempts(int maxAttempts);
+
+    void enqueue(quint16 gad);
+    void cancel(quint16 gad);
+    void responseReceived(quint16 gad);
+
+    int pending() const;
+    bool isRunning() const;
+
+    /* Time in ms from start() to the last answered or dropped read, -1 while running */
+    qint64 duration() const;
+
+public slots:
+    /* stop() pauses, pending reads are kept for the next start() */
+    void start();
+    void stop();
+
+signals:
+    void sendRead(quint16 gad);
+    void noResponse(quint16 gad);
+    void finished(qint64 duration);
+
+private:
+    struct Entry {
+        int attempts {0};
+        qint64 due {0};
+        bool sent {false};
+    };
+
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    QQueue<quint16> m_queue;
+    QSet<quint16> m_queued;
+    QHash<quint16, Entry> m_inflight;
+    int m_rate {20};
+    int m_maxAttempts {3};
+    int m_responseTimeout {1000};
+    int m_backoff {500};
+    double m_tokens {0};
+    qint64 m_lastRefill {0};
+    qint64 m_duration {-1};
+
+    void _tick();
+    void _checkFinished();
+};
+
+#endif // KNXREADSCHEDULER_H
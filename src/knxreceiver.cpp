@@ -0,0 +1,107 @@
+#include "knxreceiver.h"
+#include <QDateTime>
+#include "knxdispatchtable.h"
+#include "knxhistory.h"
+#include "knxlogging.h"
+#include "knxmetrics.h"
+#include "knxobject.h"
+#include "knxreadmanager.h"
+#include "knxreadscheduler.h"
+#include "knxsnapshot.h"
+
+#define KNX_RESPONSE        (0x01)
+#define KNX_WRITE           (0x02)
+
+KnxReceiver::KnxReceiver(KnxDispatchTable &objects, KnxMetrics &metrics, KnxReadScheduler &readScheduler,
+                         KnxReadManager &readManager, KnxSnapshot &snapshot, KnxHistory &history)
+    : m_objects(objects)
+    , m_metrics(metrics)
+    , m_readScheduler(readScheduler)
+    , m_readManager(readManager)
+    , m_snapshot(snapshot)
+    , m_history(history)
+{
+}
+
+void KnxReceiver::handle(quint16 src, quint16 dest, unsigned char *buffer, int len)
+{
+    Q_UNUSED(src)
+    if(len < 2)
+    {
+        qCWarning(lcKnxFrame) << "Read EIBGetGroup_Src Invalid packet";
+        return;
+    }
+    unsigned char cmd = static_cast<unsigned char>(((buffer[0] & 0x03) << 2) | ((buffer[1] & 0xC0) >> 6));
+    m_metrics.telegram(dest, cmd);
+    KnxObject *obj = m_objects.object(dest);
+    if(obj)
+    {
+        const bool value = (cmd == KNX_WRITE) | (cmd == KNX_RESPONSE);
+        if(value)
+        {
+            if(cmd == KNX_WRITE)
+                m_spontaneous[dest >> 6] |= quint64(1) << (dest & 0x3F);
+            const qint64 now = QDateTime::currentMSecsSinceEpoch();
+            m_readScheduler.responseReceived(dest);
+            m_snapshot.store(dest, obj->dpt(), buffer, len, now);
+            m_history.record(dest, buffer, len, now);
+        }
+        const KnxObject::Update update = obj->reciveFrame(buffer, len);
+        if(value)
+        {
+            /* Read waiters see the decoded value */
+            m_readManager.valueReceived(dest);
+        }
+        switch(update)
+        {
+        case KnxObject::Propagated:
+            m_propagated++;
+            break;
+        case KnxObject::Suppressed:
+            m_suppressed++;
+            break;
+        case KnxObject::Throttled:
+            m_throttled++;
+            break;
+        case KnxObject::Deferred:
+            m_deferred++;
+            break;
+        case KnxObject::Invalid:
+            m_metrics.decodeError(obj->dpt());
+            break;
+        case KnxObject::Unsupported:
+            m_unsupported++;
+            break;
+        case KnxObject::Ignored:
+            break;
+        }
+    }
+    else
+    {
+        m_metrics.unknown();
+        if(m_objects.markNotManaged(dest))
+        {
+            qCDebug(lcKnx) << "TODO: Unknown KNX Object " << gadToStr(dest);
+        }
+    }
+}
+
+quint64 KnxReceiver::propagated() const {
+    return m_propagated;
+}
+
+quint64 KnxReceiver::suppressed() const {
+    return m_suppressed;
+}
+
+quint64 KnxReceiver::throttled() const {
+    return m_throttled;
+}
+
+quint64 KnxReceiver::deferred() const {
+    return m_deferred;
+}
+
+quint64 KnxReceiver::unsupported() const {
+    return m_unsupported;
+}
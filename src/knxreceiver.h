@@ -0,0 +1,58 @@
+#ifndef KNXRECEIVER_H
+#define KNXRECEIVER_H
+
+#include <QtGlobal>
+
+class KnxDispatchTable;
+class KnxHistory;
+class KnxMetrics;
+class KnxReadManager;
+class KnxReadScheduler;
+class KnxSnapshot;
+
+/* Work done on the object thread for every telegram taken from a link.
+ *
+ * The telegram is counted, dispatched to its KnxObject, stored in the
+ * snapshot and the history, and completes the reads waiting for it. This
+ * is the hot path from the ring of the I/O thread to valueChanged: it must
+ * not allocate once every group address has been seen. KnxBus owns the
+ * tables, the receiver only borrows them. */
+class KnxReceiver
+{
+public:
+    KnxReceiver(KnxDispatchTable &objects, KnxMetrics &metrics, KnxReadScheduler &readScheduler,
+                KnxReadManager &readManager, KnxSnapshot &snapshot, KnxHistory &history);
+
+    KnxReceiver(const KnxReceiver &) = delete;
+    KnxReceiver &operator=(const KnxReceiver &) = delete;
+
+    /* buffer is the frame from the APCI, as received from knxd */
+    void handle(quint16 src, quint16 dest, unsigned char *buffer, int len);
+
+    /* Group addresses written by other devices, they change on their own */
+    inline bool isSpontaneous(quint16 gad) const {
+        return m_spontaneous[gad >> 6] & (Q_UINT64_C(1) << (gad & 0x3F));
+    }
+
+    quint64 propagated() const;
+    quint64 suppressed() const;
+    quint64 throttled() const;
+    quint64 deferred() const;
+    quint64 unsupported() const;
+
+private:
+    KnxDispatchTable &m_objects;
+    KnxMetrics &m_metrics;
+    KnxReadScheduler &m_readScheduler;
+    KnxReadManager &m_readManager;
+    KnxSnapshot &m_snapshot;
+    KnxHistory &m_history;
+    quint64 m_spontaneous[65536 / 64] {};
+    quint64 m_propagated {0};
+    quint64 m_suppressed {0};
+    quint64 m_throttled {0};
+    quint64 m_deferred {0};
+    quint64 m_unsupported {0};
+};
+
+#endif // KNXRECEIVER_H
@@ -0,0 +1,373 @@
+#include "knxreplaytransport.h"
+#include "knxjournal.h"
+#include "knxlogging.h"
+#include "knxobject.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QTimer>
+#include <QUrl>
+#include <QUrlQuery>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define KNX_READ            (0x00)
+#define KNX_RESPONSE        (0x01)
+#define KNX_WRITE           (0x02)
+
+static inline qint64 cpuTimestamp()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+KnxReplayTransport::KnxReplayTransport(const QString &url, QObject *parent)
+    : KnxTransport{parent}
+{
+    const QUrl u(url);
+    const QUrlQuery query(u);
+    m_path = u.path();
+    const QString speed = query.queryItemValue("speed");
+    if(speed == QLatin1String("max"))
+        m_speed = 0.0;
+    else if(!speed.isEmpty())
+        m_speed = qMax(0.0, speed.toDouble());
+    if(query.hasQueryItem("link"))
+        m_link = query.queryItemValue("link");
+    if(query.hasQueryItem("loop"))
+        m_loops = qMax(1, query.queryItemValue("loop").toInt());
+    const QStringList outage = query.queryItemValue("outage").split(':');
+    if(outage.size() == 2)
+    {
+        m_outageAt = static_cast<qint64>(outage[0].toDouble() * 1000000.0);
+        m_outageLength = static_cast<qint64>(outage[1].toDouble() * 1000000.0);
+    }
+
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(m_timer, &QTimer::timeout, this, &KnxReplayTransport::_schedule);
+}
+
+KnxReplayTransport::~KnxReplayTransport()
+{
+    close();
+}
+
+bool KnxReplayTransport::open()
+{
+    close();
+    if(knxTimestamp() < m_outageUntil)
+        return false;
+    if(pipe2(m_pipe, O_NONBLOCK | O_CLOEXEC) != 0)
+    {
+        qCWarning(lcKnx) << "Can't create replay pipe";
+        return false;
+    }
+
+    if(m_loaded)
+    {
+        /* Reconnection: resume the trace */
+        _skipMissed();
+        _schedule();
+        return true;
+    }
+    if(!_load())
+    {
+        close();
+        return false;
+    }
+    m_loaded = true;
+
+    qCInfo(lcKnx).noquote() << "KNX replay" << m_path << m_trace.size() << "telegrams," << m_devices.size()
+                            << "devices, speed" << (m_speed > 0.0 ? QString::number(m_speed) : QStringLiteral("max"));
+    m_next = 0;
+    m_loop = 0;
+    m_finished = false;
+    m_replayed = 0;
+    m_answered = 0;
+    m_missed = 0;
+    m_start = m_wallStart = knxTimestamp();
+    m_cpuStart = cpuTimestamp();
+    _schedule();
+    return true;
+}
+
+void KnxReplayTransport::close()
+{
+    m_timer->stop();
+    for(int &fd: m_pipe)
+    {
+        if(fd >= 0)
+            ::close(fd);
+        fd = -1;
+    }
+    m_armed = false;
+    m_responses.clear();
+}
+
+int KnxReplayTransport::fd() const {
+    return m_pipe[0];
+}
+
+int KnxReplayTransport::pending()
+{
+    if(m_pipe[0] < 0)
+        return -1;
+    if(!m_responses.isEmpty())
+        return 1;
+    const qint64 due = _due();
+    return (due >= 0 && due <= knxTimestamp()) ? 1 : 0;
+}
+
+int KnxReplayTransport::read(unsigned char *buffer, int size, quint16 &src, quint16 &dest)
+{
+    if(m_pipe[0] < 0)
+        return -1;
+
+    KnxTelegram telegram;
+    if(!m_responses.isEmpty())
+    {
+        telegram = m_responses.takeFirst();
+    }
+    else if(pending() > 0)
+    {
+        if(m_outageAt >= 0 && m_trace.at(m_next).timestamp >= m_outageAt)
+        {
+            qCInfo(lcKnx) << "KNX replay drops the link for" << m_outageLength / 1000000 << "ms";
+            m_outageAt = -1;
+            m_outageUntil = knxTimestamp() + m_outageLength;
+            close();
+            return -1;
+        }
+        telegram = m_trace.at(m_next++);
+        m_devices.insert(telegram.dest, telegram);
+        m_replayed++;
+        if(m_next == m_trace.size() && m_loop + 1 < m_loops)
+        {
+            m_loop++;
+            m_next = 0;
+            m_start = knxTimestamp();
+        }
+    }
+    else
+    {
+        _schedule();
+        return 0;
+    }
+
+    const int len = qMin(size, static_cast<int>(telegram.len));
+    memcpy(buffer, telegram.frame, len);
+    src = telegram.src;
+    dest = telegram.dest;
+    _schedule();
+    return len;
+}
+
+bool KnxReplayTransport::send(quint16 dest, const unsigned char *frame, int len)
+{
+    if(m_pipe[0] < 0 || len < 2 || len > KNX_MAX_FRAME_SIZE)
+        return false;
+
+    unsigned char cmd = static_cast<unsigned char>(((frame[0] & 0x03) << 2) | ((frame[1] & 0xC0) >> 6));
+    if(cmd == KNX_READ)
+    {
+        auto it = m_devices.constFind(dest);
+        if(it != m_devices.constEnd())
+        {
+            KnxTelegram response = it.value();
+            response.frame[0] = static_cast<unsigned char>((response.frame[0] & 0xFC) | (KNX_RESPONSE >> 2));
+            response.frame[1] = static_cast<unsigned char>((response.frame[1] & 0x3F) | ((KNX_RESPONSE & 0x03) << 6));
+            m_responses.append(response);
+            m_answered++;
+            _schedule();
+        }
+    }
+    else if(cmd == KNX_WRITE)
+    {
+        KnxTelegram &device = m_devices[dest];
+        device.dest = dest;
+        device.len = static_cast<quint8>(len);
+        memcpy(device.frame, frame, len);
+    }
+    return true;
+}
+
+bool KnxReplayTransport::_load()
+{
+    m_trace.clear();
+    m_devices.clear();
+    const bool journal = QFileInfo(m_path).isDir() || m_path.endsWith(QLatin1String(".knxj"));
+    if(!(journal ? _loadJournal() : _loadTrace()))
+        return false;
+
+    std::stable_sort(m_trace.begin(), m_trace.end(), [](const KnxTelegram &a, const KnxTelegram &b) {
+        return a.timestamp < b.timestamp;
+    });
+    /* Replay starts with the first telegram of the trace */
+    if(!m_trace.isEmpty())
+    {
+        const qint64 first = m_trace.first().timestamp;
+        for(KnxTelegram &telegram: m_trace)
+            telegram.timestamp -= first;
+    }
+    return true;
+}
+
+bool KnxReplayTransport::_loadTrace()
+{
+    QFile file(m_path);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        qCWarning(lcKnx) << "Can't open replay trace" << m_path;
+        return false;
+    }
+
+    int lineNumber = 0;
+    while(!file.atEnd())
+    {
+        lineNumber++;
+        const QString line = QString::fromUtf8(file.readLine()).section('#', 0, 0).simplified();
+        if(line.isEmpty())
+            continue;
+
+        const QStringList fields = line.split(' ');
+        const QByteArray apdu = QByteArray::fromHex(fields.value(3).toLatin1());
+        const int src = strToAddr(fields.value(1));
+        const int dest = strToGad(fields.value(2));
+        const bool model = fields.value(0) == QLatin1String("=");
+        bool ok = true;
+        const double time = model ? -1.0 : fields.value(0).toDouble(&ok);
+        if(!ok || (!model && time < 0.0) || fields.size() != 4 || src < 0 || dest < 0
+            || apdu.size() < 2 || apdu.size() > KNX_MAX_FRAME_SIZE)
+        {
+            qCWarning(lcKnx).noquote() << "Invalid replay line" << QStringLiteral("%1:%2").arg(m_path).arg(lineNumber);
+            continue;
+        }
+
+        KnxTelegram telegram;
+        telegram.timestamp = static_cast<qint64>(time * 1000000.0);
+        telegram.src = static_cast<quint16>(src);
+        telegram.dest = static_cast<quint16>(dest);
+        telegram.len = static_cast<quint8>(apdu.size());
+        memcpy(telegram.frame, apdu.constData(), apdu.size());
+        if(model)
+            m_devices.insert(telegram.dest, telegram);
+        else
+            m_trace.append(telegram);
+    }
+    return true;
+}
+
+bool KnxReplayTransport::_loadJournal()
+{
+    const QStringList segments = QFileInfo(m_path).isDir() ? KnxJournal::segments(m_path, m_link) : QStringList{m_path};
+    if(segments.isEmpty())
+    {
+        qCWarning(lcKnx) << "No KNX journal segment of" << m_link << "in" << m_path;
+        return false;
+    }
+
+    /* Received telegrams only: what we sent is sent again by the replayed bus */
+    KnxJournalReader reader;
+    for(const QString &segment: segments)
+    {
+        if(!reader.open(segment))
+        {
+            qCWarning(lcKnx).noquote() << reader.errorString();
+            continue;
+        }
+        m_trace.reserve(m_trace.size() + reader.size());
+        for(qsizetype i = 0; i < reader.size(); i++)
+        {
+            const KnxJournal::Record &record = reader.record(i);
+            if((record.flags & KnxJournal::Transmit) || record.len < 2 || record.len > KNX_MAX_FRAME_SIZE)
+                continue;
+            KnxTelegram telegram;
+            telegram.timestamp = reader.wallClock(record.timestamp);
+            telegram.src = record.src;
+            telegram.dest = record.dest;
+            telegram.len = record.len;
+            memcpy(telegram.frame, record.frame, record.len);
+            m_trace.append(telegram);
+        }
+    }
+    reader.close();
+    return true;
+}
+
+qint64 KnxReplayTransport::_due() const
+{
+    if(m_next >= m_trace.size())
+        return -1;
+    if(m_speed <= 0.0)
+        return m_start;
+    return m_start + static_cast<qint64>(m_trace.at(m_next).timestamp / m_speed);
+}
+
+void KnxReplayTransport::_skipMissed()
+{
+    if(m_speed <= 0.0)
+        return;
+    const qint64 now = knxTimestamp();
+    while(m_next < m_trace.size() && _due() < now)
+    {
+        const KnxTelegram &telegram = m_trace.at(m_next++);
+        m_devices.insert(telegram.dest, telegram);
+        m_missed++;
+    }
+}
+
+void KnxReplayTransport::_schedule()
+{
+    if(pending() > 0)
+    {
+        _arm();
+        return;
+    }
+    _disarm();
+
+    const qint64 due = _due();
+    if(due >= 0)
+    {
+        m_timer->start(static_cast<int>(qMax<qint64>(0, (due - knxTimestamp() + 999999) / 1000000)));
+    }
+    else if(!m_finished && m_pipe[0] >= 0)
+    {
+        /* Queued so the last telegram is handed over before finished() */
+        m_finished = true;
+        QMetaObject::invokeMethod(this, &KnxReplayTransport::_finish, Qt::QueuedConnection);
+    }
+}
+
+void KnxReplayTransport::_arm()
+{
+    if(m_armed)
+        return;
+    const char c = 0;
+    if(::write(m_pipe[1], &c, 1) == 1)
+        m_armed = true;
+}
+
+void KnxReplayTransport::_disarm()
+{
+    if(!m_armed)
+        return;
+    char c;
+    if(::read(m_pipe[0], &c, 1) == 1)
+        m_armed = false;
+}
+
+void KnxReplayTransport::_finish()
+{
+    const double wall = (knxTimestamp() - m_wallStart) / 1000000000.0;
+    const double cpu = (cpuTimestamp() - m_cpuStart) / 1000.0;
+    qCInfo(lcKnx).noquote().nospace() << "KNX replay finished: " << m_replayed << " telegrams in " << wall << " s, "
+                                      << (wall > 0.0 ? m_replayed / wall : 0.0) << " telegrams/s, "
+                                      << (m_replayed > 0 ? cpu / m_replayed : 0.0) << " us CPU per telegram, "
+                                      << m_answered << " reads answered, " << m_missed << " missed during outages";
+    emit finished();
+}
@@ -0,0 +1,81 @@
+#ifndef KNXREPLAYTRANSPORT_H
+#define KNXREPLAYTRANSPORT_H
+
+#include "knxtransport.h"
+#include "knxtelegram.h"
+#include <QHash>
+#include <QList>
+
+class QTimer;
+
+/* Offline stand-in for knxd, replays a captured telegram trace.
+ *
+ * URL: replay:<trace>[?speed=<factor|max>&loop=<count>&outage=<at>:<length>&link=<name>]
+ *
+ * The trace is a text file, one telegram per line:
+ *     <time ms> <source> <group address> <apdu hex>     1520.25 1.1.12 1/2/3 0080
+ *     = <source> <group address> <apdu hex>             = 1.1.20 2/1/0 00800c1a
+ * Lines starting with '=' seed the device model without being replayed,
+ * '#' starts a comment. The device model keeps the last value seen on each
+ * group address (trace and own writes) and answers GroupValueRead with it.
+ * A binary journal (see KnxJournal) is replayed instead when the url names
+ * a .knxj segment or a journal directory, received telegrams only. In a
+ * directory, only the segments of link are replayed (link0 by default,
+ * the first endpoint of KnxBus).
+ * outage drops the link when the trace reaches <at> ms and refuses to
+ * reopen for <length> ms, telegrams due meanwhile only update the device
+ * model, as they would be missed on a real bus.
+ * Throughput and CPU per telegram are logged when the trace is exhausted. */
+class KnxReplayTransport : public KnxTransport
+{
+    Q_OBJECT
+
+public:
+    explicit KnxReplayTransport(const QString &url, QObject *parent = nullptr);
+    ~KnxReplayTransport();
+
+    bool open() override;
+    void close() override;
+    int fd() const override;
+    int pending() override;
+    int read(unsigned char *buffer, int size, quint16 &src, quint16 &dest) override;
+    bool send(quint16 dest, const unsigned char *frame, int len) override;
+
+private:
+    QString m_path;
+    QString m_link {QStringLiteral("link0")};
+    double m_speed {1.0};           // 0 replays as fast as possible
+    int m_loops {1};
+    qint64 m_outageAt {-1};         // Trace offset, ns
+    qint64 m_outageLength {0};
+    qint64 m_outageUntil {0};
+    bool m_loaded {false};
+    QList<KnxTelegram> m_trace;     // timestamp is the offset in the trace, ns
+    QHash<quint16, KnxTelegram> m_devices;
+    QList<KnxTelegram> m_responses;
+    qsizetype m_next {0};
+    int m_loop {0};
+    qint64 m_start {0};
+    int m_pipe[2] {-1, -1};
+    bool m_armed {false};
+    bool m_finished {false};
+    QTimer *m_timer {nullptr};
+
+    qint64 m_wallStart {0};
+    qint64 m_cpuStart {0};
+    quint64 m_replayed {0};
+    quint64 m_answered {0};
+    quint64 m_missed {0};
+
+    bool _load();
+    bool _loadTrace();
+    bool _loadJournal();
+    qint64 _due() const;
+    void _skipMissed();
+    void _schedule();
+    void _arm();
+    void _disarm();
+    void _finish();
+};
+
+#endif // KNXREPLAYTRANSPORT_H
@@ -0,0 +1,169 @@
+#include "knxsnapshot.h"
+#include <QDebug>
+#include <cstring>
+#include <limits>
+
+#define KNX_SNAPSHOT_VERSION    (1)
+
+static const char s_magic[4] = { 'K', 'N', 'X', 'S' };
+
+KnxSnapshot::KnxSnapshot()
+{
+}
+
+KnxSnapshot::~KnxSnapshot()
+{
+    close();
+}
+
+bool KnxSnapshot::open(const QString &path)
+{
+    close();
+    m_file.setFileName(path);
+    if(!m_file.open(QIODevice::ReadWrite))
+    {
+        qWarning() << "Can't open KNX snapshot" << path << m_file.errorString();
+        return false;
+    }
+
+    bool valid = false;
+    if(m_file.size() >= static_cast<qint64>(sizeof(Header)))
+    {
+        Header header;
+        m_file.read(reinterpret_cast<char *>(&header), sizeof(Header));
+        valid = memcmp(header.magic, s_magic, sizeof(s_magic)) == 0
+                && header.version == KNX_SNAPSHOT_VERSION
+                && header.recordSize == sizeof(Record)
+                && header.count <= static_cast<quint32>(std::numeric_limits<int>::max())
+                && m_file.size() >= static_cast<qint64>(sizeof(Header)) + static_cast<qint64>(header.count) * static_cast<qint64>(sizeof(Record));
+    }
+
+    if(!valid)
+    {
+        if(m_file.size() > 0)
+            qWarning() << "Invalid KNX snapshot" << path << ", reset it";
+        Header header {};
+        memcpy(header.magic, s_magic, sizeof(s_magic));
+        header.version = KNX_SNAPSHOT_VERSION;
+        header.recordSize = sizeof(Record);
+        m_file.resize(0);
+        m_file.seek(0);
+        m_file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+        m_file.flush();
+    }
+
+    int capacity = static_cast<int>((m_file.size() - static_cast<qint64>(sizeof(Header))) / static_cast<qint64>(sizeof(Record)));
+    if(!_map(qMax(capacity, 64)))
+    {
+        close();
+        return false;
+    }
+
+    const Record *records = _records();
+    for(quint32 i = 0; i < _header()->count; i++)
+    {
+        m_index.insert(records[i].gad, i);
+    }
+    return true;
+}
+
+void KnxSnapshot::close()
+{
+    if(m_map)
+    {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    if(m_file.isOpen())
+        m_file.close();
+    m_capacity = 0;
+    m_index.clear();
+}
+
+bool KnxSnapshot::isOpen() const {
+    return m_map != nullptr;
+}
+
+bool KnxSnapshot::reserve(int count)
+{
+    if(!m_map)
+        return false;
+    /* Index slots reserved up front keep store() allocation free */
+    m_index.reserve(count);
+    if(count <= m_capacity)
+        return true;
+    return _map(count);
+}
+
+const KnxSnapshot::Record *KnxSnapshot::record(quint16 gad) const
+{
+    if(!m_map)
+        return nullptr;
+    auto it = m_index.constFind(gad);
+    if(it == m_index.constEnd())
+        return nullptr;
+    return &_records()[it.value()];
+}
+
+void KnxSnapshot::store(quint16 gad, quint16 dpt, const unsigned char *frame, int len, qint64 timestamp)
+{
+    if(!m_map || len < 2 || len > MaxFrameSize)
+        return;
+
+    auto it = m_index.constFind(gad);
+    const bool append = it == m_index.constEnd();
+    const quint32 slot = append ? _header()->count : it.value();
+    if(append && static_cast<int>(slot) >= m_capacity && !_map(m_capacity * 2))
+        return;
+
+    Record &rec = _records()[slot];
+    rec.gad = gad;
+    rec.dpt = dpt;
+    rec.len = static_cast<quint8>(len);
+    rec.flags = 0;
+    rec.reserved = 0;
+    rec.timestamp = timestamp;
+    memcpy(rec.frame, frame, len);
+
+    /* Count the record only once written, a crash never exposes a blank slot */
+    if(append)
+    {
+        _header()->count = slot + 1;
+        m_index.insert(gad, slot);
+    }
+}
+
+int KnxSnapshot::size() const {
+    return m_map ? static_cast<int>(_header()->count) : 0;
+}
+
+KnxSnapshot::Header *KnxSnapshot::_header() const {
+    return reinterpret_cast<Header *>(m_map);
+}
+
+KnxSnapshot::Record *KnxSnapshot::_records() const {
+    return reinterpret_cast<Record *>(m_map + sizeof(Header));
+}
+
+bool KnxSnapshot::_map(int capacity)
+{
+    if(m_map)
+    {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    const qint64 size = static_cast<qint64>(sizeof(Header)) + static_cast<qint64>(capacity) * static_cast<qint64>(sizeof(Record));
+    if(m_file.size() < size && !m_file.resize(size))
+    {
+        qWarning() << "Can't resize KNX snapshot" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+    m_map = m_file.map(0, size);
+    if(!m_map)
+    {
+        qWarning() << "Can't map KNX snapshot" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+    m_capacity = capacity;
+    return true;
+}
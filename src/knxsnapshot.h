@@ -0,0 +1,68 @@
+#ifndef KNXSNAPSHOT_H
+#define KNXSNAPSHOT_H
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+
+/* Memory-mapped store of the last telegram received for each group address.
+ *
+ * The file is a small header followed by fixed-size records, one per group
+ * address. A record keeps the raw frame (APCI + payload), the DPT it was
+ * decoded with and the reception time, so it can be replayed through
+ * KnxObject::reciveFrame() on the next start. Stores are a memcpy in the
+ * mapping, the kernel writes the pages back. */
+class KnxSnapshot
+{
+public:
+    static constexpr int MaxFrameSize = 16;
+
+    struct Record {
+        quint16 gad;
+        quint16 dpt;
+        quint8 len;
+        quint8 flags;
+        quint16 reserved;
+        qint64 timestamp;
+        unsigned char frame[MaxFrameSize];
+    };
+    static_assert(sizeof(Record) == 32, "KnxSnapshot::Record must stay 32 bytes");
+
+    KnxSnapshot();
+    ~KnxSnapshot();
+
+    KnxSnapshot(const KnxSnapshot &) = delete;
+    KnxSnapshot &operator=(const KnxSnapshot &) = delete;
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const;
+
+    /* Grow the mapping so that at least count records fit without remapping */
+    bool reserve(int count);
+
+    const Record *record(quint16 gad) const;
+    void store(quint16 gad, quint16 dpt, const unsigned char *frame, int len, qint64 timestamp);
+
+    int size() const;
+
+private:
+    struct Header {
+        char magic[4];
+        quint16 version;
+        quint16 recordSize;
+        quint32 count;
+        quint32 reserved;
+    };
+
+    QFile m_file;
+    uchar *m_map {nullptr};
+    int m_capacity {0};
+    QHash<quint16, quint32> m_index;
+
+    Header *_header() const;
+    Record *_records() const;
+    bool _map(int capacity);
+};
+
+#endif // KNXSNAPSHOT_H
@@ -0,0 +1,50 @@
+#ifndef KNXSPSCRING_H
+#define KNXSPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+
+/* Lock-free single producer / single consumer ring of trivially copyable
+ * records. Size must be a power of two. push() must only be called from
+ * the producer thread and pop() from the consumer thread. */
+template<typename T, unsigned Size>
+class KnxSpscRing
+{
+    static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "KnxSpscRing size must be a power of two");
+
+public:
+    bool push(const T &item) {
+        const unsigned head = m_head.load(std::memory_order_relaxed);
+        if(head - m_tail.load(std::memory_order_acquire) == Size)
+            return false;
+        m_items[head & (Size - 1)] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &item) {
+        const unsigned tail = m_tail.load(std::memory_order_relaxed);
+        if(tail == m_head.load(std::memory_order_acquire))
+            return false;
+        item = m_items[tail & (Size - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    unsigned size() const {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr unsigned capacity() {
+        return Size;
+    }
+
+private:
+    static constexpr std::size_t CacheLine = 64;
+
+    alignas(CacheLine) std::atomic<unsigned> m_head {0};
+    alignas(CacheLine) std::atomic<unsigned> m_tail {0};
+    alignas(CacheLine) T m_items[Size];
+};
+
+#endif // KNXSPSCRING_H
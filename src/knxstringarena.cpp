@@ -0,0 +1,49 @@
+#include "knxstringarena.h"
+#include <algorithm>
+
+KnxStringArena::KnxStringArena()
+{
+}
+
+KnxStringArena &KnxStringArena::names()
+{
+    /* Never deleted, see the class comment */
+    static KnxStringArena *arena = new KnxStringArena;
+    return *arena;
+}
+
+QString KnxStringArena::intern(QStringView str)
+{
+    if(str.isEmpty())
+        return QString();
+
+    auto it = m_index.constFind(str);
+    if(it != m_index.constEnd())
+        return QString::fromRawData(it->data(), it->size());
+
+    if(str.size() > m_left)
+    {
+        /* Oversized strings get a block of their own */
+        const qsizetype size = std::max(BlockSize, str.size());
+        m_blocks.emplace_back(new QChar[size]);
+        m_current = m_blocks.back().get();
+        m_left = size;
+        m_capacity += size * static_cast<qsizetype>(sizeof(QChar));
+    }
+
+    QChar *data = m_current;
+    std::copy(str.begin(), str.end(), data);
+    m_current += str.size();
+    m_left -= str.size();
+    m_used += str.size() * static_cast<qsizetype>(sizeof(QChar));
+    m_index.insert(QStringView(data, str.size()));
+    return QString::fromRawData(data, str.size());
+}
+
+qsizetype KnxStringArena::capacity() const {
+    return m_capacity;
+}
+
+qsizetype KnxStringArena::used() const {
+    return m_used;
+}
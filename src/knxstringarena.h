@@ -0,0 +1,48 @@
+#ifndef KNXSTRINGARENA_H
+#define KNXSTRINGARENA_H
+
+#include <QSet>
+#include <QString>
+#include <QStringView>
+#include <memory>
+#include <vector>
+
+/* Append-only UTF-16 storage of the object names.
+ *
+ * Strings are copied back to back in large blocks and handed out with
+ * QString::fromRawData(), so tens of thousands of object names cost one
+ * allocation per block instead of one per name. Those strings do not own
+ * their data and the KaZa server and QML copy them freely, so the blocks
+ * are never freed: names() lives until the process exits, past the static
+ * destructors. Identical strings are stored once, a project loaded again
+ * or by another bus does not grow it. Object thread only. */
+class KnxStringArena
+{
+public:
+    static constexpr qsizetype BlockSize = 64 * 1024;
+
+    /* Arena of the object names of every bus of the process */
+    static KnxStringArena &names();
+
+    KnxStringArena(const KnxStringArena &) = delete;
+    KnxStringArena &operator=(const KnxStringArena &) = delete;
+
+    QString intern(QStringView str);
+
+    /* Bytes reserved by the blocks */
+    qsizetype capacity() const;
+    /* Bytes used by the strings */
+    qsizetype used() const;
+
+private:
+    KnxStringArena();
+
+    std::vector<std::unique_ptr<QChar[]>> m_blocks;
+    QSet<QStringView> m_index;
+    qsizetype m_capacity {0};
+    qsizetype m_used {0};
+    QChar *m_current {nullptr};
+    qsizetype m_left {0};
+};
+
+#endif // KNXSTRINGARENA_H
@@ -0,0 +1,35 @@
+#ifndef KNXTELEGRAM_H
+#define KNXTELEGRAM_H
+
+#include <QtGlobal>
+#include <chrono>
+
+/* Largest group frame (APCI + payload) carried between threads: DPT 16 is 2 + 14 bytes */
+#define KNX_MAX_FRAME_SIZE  (16)
+
+/* Monotonic timestamp in ns, shared by the I/O and the object threads */
+static inline qint64 knxTimestamp()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* Group telegram received from knxd, handed from the I/O thread to the object thread */
+struct KnxTelegram {
+    qint64 timestamp;
+    quint16 src;
+    quint16 dest;
+    quint8 len;
+    unsigned char frame[KNX_MAX_FRAME_SIZE];
+};
+
+/* Group telegram to send, handed from the object thread to the I/O thread */
+struct KnxTxRequest {
+    qint64 timestamp;
+    quint16 gad;
+    quint8 len;
+    quint8 lane;
+    bool coalesce;
+    unsigned char frame[KNX_MAX_FRAME_SIZE];
+};
+
+#endif // KNXTELEGRAM_H
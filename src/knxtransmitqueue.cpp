@@ -0,0 +1,108 @@
+#include "knxtransmitqueue.h"
+#include <cstring>
+
+KnxTransmitQueue::KnxTransmitQueue(int capacity)
+{
+    m_pool.resize(capacity);
+    m_free.reserve(capacity);
+    for(int i = capacity - 1; i >= 0; i--)
+        m_free.append(i);
+    for(Ring &ring: m_lanes)
+        ring.slots.resize(capacity);
+    m_pending.reserve(capacity);
+}
+
+bool KnxTransmitQueue::enqueue(quint16 gad, const unsigned char *data, int len, Lane lane, bool coalesce, qint64 now)
+{
+    if(len > MaxFrameSize)
+    {
+        m_dropped++;
+        return false;
+    }
+
+    if(coalesce)
+    {
+        auto it = m_pending.constFind(gad);
+        if(it != m_pending.constEnd())
+        {
+            Frame &frame = m_pool[it.value()];
+            if(frame.lane <= lane)
+            {
+                frame.len = static_cast<quint8>(len);
+                memcpy(frame.data, data, len);
+                m_coalesced++;
+                return true;
+            }
+            /* Queued in a lower priority lane: the new frame supersedes it,
+             * the old slot is released when it reaches the head of its lane */
+            frame.coalesce = false;
+            frame.len = 0;
+            m_pending.erase(it);
+            m_size--;
+        }
+    }
+
+    if(m_free.isEmpty())
+    {
+        m_dropped++;
+        return false;
+    }
+
+    int slot = m_free.takeLast();
+    Frame &frame = m_pool[slot];
+    frame.gad = gad;
+    frame.len = static_cast<quint8>(len);
+    frame.lane = static_cast<quint8>(lane);
+    frame.coalesce = coalesce;
+    frame.enqueued = now;
+    memcpy(frame.data, data, len);
+
+    Ring &ring = m_lanes[lane];
+    ring.slots[(ring.head + ring.count) % ring.slots.size()] = slot;
+    ring.count++;
+    m_size++;
+
+    if(coalesce)
+        m_pending.insert(gad, slot);
+    return true;
+}
+
+const KnxTransmitQueue::Frame *KnxTransmitQueue::front()
+{
+    for(Ring &ring: m_lanes)
+    {
+        while(ring.count > 0)
+        {
+            int slot = ring.slots[ring.head];
+            if(m_pool[slot].len > 0)
+                return &m_pool[slot];
+            _release(ring);
+        }
+    }
+    return nullptr;
+}
+
+void KnxTransmitQueue::pop()
+{
+    for(Ring &ring: m_lanes)
+    {
+        if(ring.count == 0)
+            continue;
+
+        const Frame &frame = m_pool[ring.slots[ring.head]];
+        if(frame.coalesce)
+            m_pending.remove(frame.gad);
+        if(frame.len > 0)
+            m_size--;
+        _release(ring);
+        return;
+    }
+}
+
+void KnxTransmitQueue::_release(Ring &ring)
+{
+    int slot = ring.slots[ring.head];
+    ring.head = (ring.head + 1) % ring.slots.size();
+    ring.count--;
+    m_free.append(slot);
+}
@@ -0,0 +1,83 @@
+#ifndef KNXTRANSMITQUEUE_H
+#define KNXTRANSMITQUEUE_H
+
+#include <QHash>
+#include <QList>
+#include <QtGlobal>
+
+/* Bounded transmit queue of KNX group telegrams.
+ *
+ * Frames live in a pool preallocated at construction, each priority lane
+ * is a ring of pool indices. A write to a group address that still has a
+ * write waiting in the queue replaces its payload (last value wins)
+ * instead of taking a new slot. When the pool is full, new frames are
+ * dropped and counted. */
+class KnxTransmitQueue
+{
+public:
+    enum Lane {
+        High = 0,       // Switching, alarms
+        Normal,         // Values, dimming
+        Low,            // Read requests
+        LaneCount
+    };
+
+    static constexpr int MaxFrameSize = 16;
+
+    struct Frame {
+        quint16 gad;
+        quint8 len;
+        quint8 lane;
+        bool coalesce;
+        qint64 enqueued;
+        unsigned char data[MaxFrameSize];
+    };
+
+    explicit KnxTransmitQueue(int capacity = 256);
+
+    /* Queue a frame, return false if it was dropped */
+    bool enqueue(quint16 gad, const unsigned char *data, int len, Lane lane, bool coalesce, qint64 now);
+
+    /* Highest priority frame, nullptr if empty. Stays valid until pop() */
+    const Frame *front();
+    void pop();
+
+    inline int size() const {
+        return m_size;
+    }
+
+    inline bool isEmpty() const {
+        return m_size == 0;
+    }
+
+    inline int capacity() const {
+        return m_pool.size();
+    }
+
+    inline quint64 dropped() const {
+        return m_dropped;
+    }
+
+    inline quint64 coalesced() const {
+        return m_coalesced;
+    }
+
+private:
+    struct Ring {
+        QList<int> slots;
+        int head {0};
+        int count {0};
+    };
+
+    QList<Frame> m_pool;
+    QList<int> m_free;
+    Ring m_lanes[LaneCount];
+    QHash<quint16, int> m_pending;
+    int m_size {0};
+    quint64 m_dropped {0};
+    quint64 m_coalesced {0};
+
+    void _release(Ring &ring);
+};
+
+#endif // KNXTRANSMITQUEUE_H
@@ -0,0 +1,15 @@
+#include "knxtransport.h"
+#include "knxdtransport.h"
+#include "knxreplaytransport.h"
+
+KnxTransport::KnxTransport(QObject *parent)
+    : QObject{parent}
+{
+}
+
+KnxTransport *KnxTransport::create(const QString &url, QObject *parent)
+{
+    if(url.startsWith(QLatin1String("replay:")))
+        return new KnxReplayTransport(url, parent);
+    return new KnxdTransport(url, parent);
+}
@@ -0,0 +1,40 @@
+#ifndef KNXTRANSPORT_H
+#define KNXTRANSPORT_H
+
+#include <QObject>
+#include <QString>
+
+/* Group telegram link used by KnxConnection.
+ *
+ * The transport lives in the I/O thread and exposes a pollable file
+ * descriptor: the connection reads as long as pending() reports a complete
+ * telegram. create() picks the implementation from the URL scheme,
+ * "replay:" selects the trace replay, anything else is given to knxd. */
+class KnxTransport : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KnxTransport(QObject *parent = nullptr);
+
+    virtual bool open() = 0;
+    virtual void close() = 0;
+
+    /* File descriptor readable when telegrams are available */
+    virtual int fd() const = 0;
+
+    /* > 0 when a complete telegram can be read without blocking */
+    virtual int pending() = 0;
+
+    /* Frame length, 0 when nothing is available, < 0 when the link is lost */
+    virtual int read(unsigned char *buffer, int size, quint16 &src, quint16 &dest) = 0;
+    virtual bool send(quint16 dest, const unsigned char *frame, int len) = 0;
+
+    static KnxTransport *create(const QString &url, QObject *parent = nullptr);
+
+signals:
+    /* No more telegram will be received (end of a replayed trace) */
+    void finished();
+};
+
+#endif // KNXTRANSPORT_H
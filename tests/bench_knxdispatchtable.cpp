@@ -0,0 +1,99 @@
+#include <QTest>
+#include <QMap>
+#include <QRandomGenerator>
+#include "knxdispatchtable.h"
+
+/* Lookup of a telegram stream on a 3,000 group address project: the flat
+ * dispatch table against the former QMap + not managed QList. */
+
+static constexpr int ObjectCount = 3000;
+static constexpr int UnmanagedCount = 300;
+static constexpr int TelegramCount = 100000;
+
+class BenchKnxDispatchTable : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void qmap();
+    void dispatchTable();
+
+private:
+    QList<quint16> m_managed;
+    QList<quint16> m_telegrams;
+};
+
+void BenchKnxDispatchTable::initTestCase()
+{
+    QRandomGenerator rng(0x4b4e58);
+    QList<bool> used(65536, false);
+    auto pick = [&rng, &used]() {
+        quint16 gad;
+        do {
+            /* Main 0-15, middle 0-7, sub 0-255 as ETS usually allocates */
+            gad = static_cast<quint16>(rng.bounded(16 << 11));
+        } while(used[gad]);
+        used[gad] = true;
+        return gad;
+    };
+    for(int i = 0; i < ObjectCount; i++)
+        m_managed.append(pick());
+    QList<quint16> unmanaged;
+    for(int i = 0; i < UnmanagedCount; i++)
+        unmanaged.append(pick());
+
+    /* 90% of the traffic hits a managed object */
+    for(int i = 0; i < TelegramCount; i++)
+    {
+        if(rng.bounded(10) == 0)
+            m_telegrams.append(unmanaged[rng.bounded(UnmanagedCount)]);
+        else
+            m_telegrams.append(m_managed[rng.bounded(ObjectCount)]);
+    }
+}
+
+void BenchKnxDispatchTable::qmap()
+{
+    QMap<quint16, KnxObject*> objects;
+    QList<uint16_t> notmanaged;
+    for(quint16 gad: std::as_const(m_managed))
+        objects[gad] = reinterpret_cast<KnxObject*>(quintptr(gad) << 4);
+
+    quintptr sum = 0;
+    QBENCHMARK {
+        for(quint16 dest: std::as_const(m_telegrams))
+        {
+            if(objects.contains(dest))
+                sum += reinterpret_cast<quintptr>(objects[dest]);
+            else if(!notmanaged.contains(dest))
+                notmanaged.append(dest);
+        }
+    }
+    QVERIFY(sum != 0);
+    QCOMPARE(notmanaged.size(), UnmanagedCount);
+}
+
+void BenchKnxDispatchTable::dispatchTable()
+{
+    KnxDispatchTable table;
+    for(quint16 gad: std::as_const(m_managed))
+        table.insert(gad, reinterpret_cast<KnxObject*>(quintptr(gad) << 4));
+
+    quintptr sum = 0;
+    QBENCHMARK {
+        for(quint16 dest: std::as_const(m_telegrams))
+        {
+            if(KnxObject *obj = table.object(dest))
+                sum += reinterpret_cast<quintptr>(obj);
+            else
+                table.markNotManaged(dest);
+        }
+    }
+    QVERIFY(sum != 0);
+    QCOMPARE(table.notManagedCount(), UnmanagedCount);
+}
+
+QTEST_APPLESS_MAIN(BenchKnxDispatchTable)
+
+#include "bench_knxdispatchtable.moc"
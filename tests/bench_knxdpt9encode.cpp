@@ -0,0 +1,91 @@
+#include <QTest>
+#include <QRandomGenerator>
+#include <vector>
+#include "knxdpt.h"
+
+/* encode_dpt9() against the loop based encoder it replaced, on one million
+ * sensor range values and one million values over the full DPT 9 range. */
+
+static constexpr int Count = 1 << 20;
+
+static inline void legacyEncodeDpt9(unsigned char *data, float value)
+{
+    unsigned int sign = (value < 0);
+    unsigned int exp = 0;
+    int mant = value * 100.0;
+
+    while(mant > 2047 || mant <= -2048)
+    {
+        mant = mant >> 1;
+        ++exp;
+    }
+    mant &= 0x07ff;
+    data[1] = (sign << 7) | (exp << 3) | ((mant & 0x07ff) >> 8);
+    data[2] = mant & 0xFF;
+}
+
+class BenchKnxDpt9Encode : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void encode_data();
+    void encode();
+
+private:
+    std::vector<float> m_sensor;
+    std::vector<float> m_full;
+    std::vector<unsigned char> m_payloads;
+};
+
+void BenchKnxDpt9Encode::initTestCase()
+{
+    QRandomGenerator rng(24);
+    m_sensor.resize(Count);
+    m_full.resize(Count);
+    for(int i = 0; i < Count; i++)
+    {
+        m_sensor[i] = static_cast<float>(rng.bounded(60.0) - 30.0);
+        m_full[i] = static_cast<float>(rng.bounded(1340000.0) - 670000.0);
+    }
+    m_payloads.resize(3 * Count);
+}
+
+void BenchKnxDpt9Encode::encode_data()
+{
+    QTest::addColumn<bool>("legacy");
+    QTest::addColumn<bool>("full");
+
+    QTest::newRow("legacy, sensor range") << true << false;
+    QTest::newRow("encode_dpt9, sensor range") << false << false;
+    QTest::newRow("legacy, full range") << true << true;
+    QTest::newRow("encode_dpt9, full range") << false << true;
+}
+
+void BenchKnxDpt9Encode::encode()
+{
+    QFETCH(bool, legacy);
+    QFETCH(bool, full);
+
+    const std::vector<float> &values = full ? m_full : m_sensor;
+    unsigned char *data = m_payloads.data();
+    if(legacy)
+    {
+        QBENCHMARK {
+            for(int i = 0; i < Count; i++)
+                legacyEncodeDpt9(data + 3 * i, values[i]);
+        }
+    }
+    else
+    {
+        QBENCHMARK {
+            for(int i = 0; i < Count; i++)
+                encode_dpt9(data + 3 * i, values[i]);
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(BenchKnxDpt9Encode)
+
+#include "bench_knxdpt9encode.moc"
@@ -0,0 +1,78 @@
+#include <QTest>
+#include <QRandomGenerator>
+#include <vector>
+#include "knxdpt.h"
+#include "knxdptbatch.h"
+
+/* One million float payloads decoded one by one with decode_dpt9() and
+ * decode_dpt14(), then through the batched kernel selected for this CPU
+ * (KNX_DPT_KERNEL=scalar|sse2 to compare with a slower one). */
+
+static constexpr int Count = 1 << 20;
+
+class BenchKnxDptBatch : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void dpt9PerTelegram();
+    void dpt9Batch();
+    void dpt14PerTelegram();
+    void dpt14Batch();
+
+private:
+    std::vector<unsigned char> m_payloads;
+    std::vector<float> m_values;
+};
+
+void BenchKnxDptBatch::initTestCase()
+{
+    qInfo() << "Kernel" << knxDptBatchKernel();
+    std::vector<quint32> random(Count);
+    QRandomGenerator(9).fillRange(random.data(), random.size());
+    m_payloads.resize(4 * Count);
+    memcpy(m_payloads.data(), random.data(), m_payloads.size());
+    m_values.resize(Count);
+}
+
+void BenchKnxDptBatch::dpt9PerTelegram()
+{
+    QBENCHMARK {
+        for(int i = 0; i < Count; i++)
+        {
+            const unsigned char data[3] = { 0x80, m_payloads[2 * i], m_payloads[2 * i + 1] };
+            decode_dpt9(data, &m_values[i]);
+        }
+    }
+}
+
+void BenchKnxDptBatch::dpt9Batch()
+{
+    QBENCHMARK {
+        knxDecodeDpt9(m_payloads.data(), m_values.data(), Count);
+    }
+}
+
+void BenchKnxDptBatch::dpt14PerTelegram()
+{
+    QBENCHMARK {
+        for(int i = 0; i < Count; i++)
+        {
+            unsigned char data[5] = { 0x80 };
+            memcpy(data + 1, &m_payloads[4 * i], 4);
+            decode_dpt14(data, &m_values[i]);
+        }
+    }
+}
+
+void BenchKnxDptBatch::dpt14Batch()
+{
+    QBENCHMARK {
+        knxDecodeDpt14(m_payloads.data(), m_values.data(), Count);
+    }
+}
+
+QTEST_APPLESS_MAIN(BenchKnxDptBatch)
+
+#include "bench_knxdptbatch.moc"
@@ -0,0 +1,50 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include "knxjournal.h"
+#include "knxtelegram.h"
+
+/* Cost of journaling one telegram for each sync policy: fdatasync after
+ * every batch write, at most every 100 ms, or left to the kernel. */
+
+static constexpr int Telegrams = 100000;
+
+class BenchKnxJournal : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void record_data();
+    void record();
+};
+
+void BenchKnxJournal::record_data()
+{
+    QTest::addColumn<int>("syncInterval");
+
+    QTest::newRow("sync every write") << 0;
+    QTest::newRow("sync every 100 ms") << 100;
+    QTest::newRow("no sync") << -1;
+}
+
+void BenchKnxJournal::record()
+{
+    QFETCH(int, syncInterval);
+
+    QTemporaryDir dir;
+    KnxJournal journal;
+    journal.setSyncInterval(syncInterval);
+    QVERIFY(journal.open(dir.path(), QStringLiteral("link0")));
+    const unsigned char frame[] = { 0x00, 0x80, 0x0C, 0x1A };
+
+    QBENCHMARK {
+        for(int i = 0; i < Telegrams; i++)
+            journal.record(knxTimestamp(), 0x1101, static_cast<quint16>(i), false, frame, sizeof(frame));
+        journal.flush();
+    }
+    qInfo().noquote() << journal.records() << "telegrams," << journal.writeCost() << "ns per telegram in write and sync";
+    journal.close();
+}
+
+QTEST_APPLESS_MAIN(BenchKnxJournal)
+
+#include "bench_knxjournal.moc"
@@ -0,0 +1,90 @@
+#include <QCoreApplication>
+#include <QFile>
+#include <QProcess>
+#include <QTextStream>
+#include <unistd.h>
+#include "knxobject.h"
+#include "knxstringarena.h"
+
+/* Resident memory per KnxObject for a 20k group address project, with
+ * names owned by each object ("main.middle.name" built per object, as
+ * before the arena) and with names interned in KnxStringArena.
+ *
+ *   bench_knxobjectmemory                  run both
+ *   bench_knxobjectmemory owned|arena      one of them
+ *
+ * Each mode runs in its own process so the heaps are not shared. The
+ * objects are built on the stub KaZaObject of the tests, which keeps its
+ * name as the server does. */
+
+static constexpr int MainGroups = 10;
+static constexpr int MiddleGroups = 8;
+static constexpr int SubGroups = 250;
+
+static QTextStream out(stdout);
+
+/* Resident set size of the process in bytes, 0 when unknown */
+static qint64 residentMemory()
+{
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if(!statm.open(QIODevice::ReadOnly))
+        return 0;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if(fields.size() < 2)
+        return 0;
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+}
+
+static int run(const QString &mode)
+{
+    const bool arena = mode == QLatin1String("arena");
+    const int count = MainGroups * MiddleGroups * SubGroups;
+
+    /* Range names and group address names as the catalog string table holds them */
+    QStringList ranges;
+    for(int m = 0; m < MainGroups; m++)
+    {
+        for(int s = 0; s < MiddleGroups; s++)
+            ranges.append(QStringLiteral("Main %1.Middle %2").arg(m).arg(s));
+    }
+    QStringList names;
+    for(int g = 0; g < SubGroups; g++)
+        names.append(QStringLiteral("Address %1").arg(g));
+
+    QList<KnxObject *> objects;
+    objects.reserve(count);
+    const qint64 before = residentMemory();
+    for(int i = 0; i < count; i++)
+    {
+        const quint16 gad = static_cast<quint16>(((i / SubGroups) << 8) | (i % SubGroups));
+        const QString name = ranges[i / SubGroups] + '.' + names[i % SubGroups];
+        objects.append(new KnxObject(arena ? KnxStringArena::names().intern(name) : name, gad, 0x0901));
+    }
+    const qint64 after = residentMemory();
+
+    out << mode.leftJustified(8) << count << " objects, " << (after - before) / count << " bytes per object";
+    if(arena)
+        out << ", names " << KnxStringArena::names().used() / 1024 << " of " << KnxStringArena::names().capacity() / 1024 << " KiB of arena";
+    out << Qt::endl;
+    qDeleteAll(objects);
+    return before > 0 && after > 0 ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    if(args.size() == 2)
+        return run(args[1]);
+
+    int ret = 0;
+    for(const char *mode: { "owned", "arena" })
+    {
+        QProcess process;
+        process.setProcessChannelMode(QProcess::ForwardedChannels);
+        process.start(app.applicationFilePath(), { QString::fromLatin1(mode) });
+        process.waitForFinished(-1);
+        ret |= process.exitCode();
+    }
+    return ret;
+}
@@ -0,0 +1,211 @@
+#include <QCoreApplication>
+#include <QDomDocument>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <minizip/unzip.h>
+#include <minizip/zip.h>
+#include <sys/resource.h>
+#include "knxprojreader.h"
+
+/* Parse time and peak RSS of a synthetic 20k group address project, through
+ * the former QDomDocument path and through KnxProjReader.
+ *
+ *   bench_knxprojreader                      generate a project, run both
+ *   bench_knxprojreader dom|stream <path>    one parser on an existing project
+ *
+ * Each parser runs in its own process so peak RSS is not shared. */
+
+static constexpr int MainGroups = 10;
+static constexpr int MiddleGroups = 8;
+static constexpr int SubGroups = 250;
+static constexpr int Devices = 4000;
+static constexpr int ComObjectsPerDevice = 5;
+static constexpr int ParametersPerDevice = 40;
+
+static QTextStream out(stdout);
+
+static long peakRssKiB()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static QByteArray installationXml()
+{
+    const int addresses = MainGroups * MiddleGroups * SubGroups;
+    QByteArray xml;
+    xml.reserve(64 * 1024 * 1024);
+    xml += "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+           "<KNX xmlns=\"http://knx.org/xml/project/21\">\n"
+           "<Project Id=\"P-0001\">\n"
+           "<Installations>\n"
+           "<Installation Name=\"Bench\" InstallationId=\"0\">\n";
+
+    /* Device subtree, larger than the group addresses as in real projects */
+    xml += "<Topology><Area Id=\"P-0001-0_A-1\" Address=\"1\"><Line Id=\"P-0001-0_L-1\" Address=\"1\">\n";
+    int ref = 0;
+    for(int d = 0; d < Devices; d++)
+    {
+        xml += "<DeviceInstance Id=\"P-0001-0_DI-" + QByteArray::number(d + 1) + "\" Address=\"" + QByteArray::number(d % 256)
+               + "\" ProductRefId=\"M-0083_H-1-O0000_P-1\" Hardware2ProgramRefId=\"M-0083_H-1-HP-0001\">\n<ParameterInstanceRefs>\n";
+        for(int p = 0; p < ParametersPerDevice; p++)
+            xml += "<ParameterInstanceRef RefId=\"M-0083_A-0001-10-0000_P-" + QByteArray::number(p) + "_R-" + QByteArray::number(p)
+                   + "\" Value=\"" + QByteArray::number((d * 31 + p) % 100) + "\" />\n";
+        xml += "</ParameterInstanceRefs>\n<ComObjectInstanceRefs>\n";
+        for(int c = 0; c < ComObjectsPerDevice; c++)
+            xml += "<ComObjectInstanceRef RefId=\"M-0083_A-0001-10-0000_O-" + QByteArray::number(c) + "_R-" + QByteArray::number(c)
+                   + "\" Links=\"GA-" + QByteArray::number(ref++ % addresses + 1) + "\" />\n";
+        xml += "</ComObjectInstanceRefs>\n</DeviceInstance>\n";
+    }
+    xml += "</Line></Area></Topology>\n";
+
+    xml += "<GroupAddresses><GroupRanges>\n";
+    int id = 0;
+    for(int m = 0; m < MainGroups; m++)
+    {
+        xml += "<GroupRange Id=\"P-0001-0_GR-" + QByteArray::number(m + 1) + "\" Name=\"Main " + QByteArray::number(m) + "\">\n";
+        for(int s = 0; s < MiddleGroups; s++)
+        {
+            xml += "<GroupRange Id=\"P-0001-0_GR-" + QByteArray::number(100 + m * MiddleGroups + s) + "\" Name=\"Middle "
+                   + QByteArray::number(s) + "\">\n";
+            for(int g = 0; g < SubGroups; g++)
+            {
+                const int address = (m << 11) | (s << 8) | g;
+                xml += "<GroupAddress Id=\"P-0001-0_GA-" + QByteArray::number(++id) + "\" Address=\"" + QByteArray::number(address)
+                       + "\" Name=\"Address " + QByteArray::number(g) + "\" DatapointType=\"DPST-9-1\" />\n";
+            }
+            xml += "</GroupRange>\n";
+        }
+        xml += "</GroupRange>\n";
+    }
+    xml += "</GroupRanges></GroupAddresses>\n"
+           "</Installation>\n</Installations>\n</Project>\n</KNX>\n";
+    return xml;
+}
+
+static bool addEntry(zipFile zip, const char *name, const QByteArray &data)
+{
+    zip_fileinfo info {};
+    if(zipOpenNewFileInZip64(zip, name, &info, NULL, 0, NULL, 0, NULL, Z_DEFLATED, Z_DEFAULT_COMPRESSION, 1) != ZIP_OK)
+        return false;
+    const bool ok = zipWriteInFileInZip(zip, data.constData(), static_cast<unsigned>(data.size())) == ZIP_OK;
+    return zipCloseFileInZip(zip) == ZIP_OK && ok;
+}
+
+static bool generate(const QString &path)
+{
+    zipFile zip = zipOpen64(path.toStdString().c_str(), APPEND_STATUS_CREATE);
+    if(zip == NULL)
+        return false;
+    const QByteArray project = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+                               "<KNX xmlns=\"http://knx.org/xml/project/21\"><Project Id=\"P-0001\">"
+                               "<ProjectInformation Name=\"Bench\" /></Project></KNX>\n";
+    const QByteArray installation = installationXml();
+    const bool ok = addEntry(zip, "P-0001/project.xml", project) && addEntry(zip, "P-0001/0.xml", installation);
+    zipClose(zip, NULL);
+    out << "Generated " << (MainGroups * MiddleGroups * SubGroups) << " group addresses, 0.xml "
+        << (installation.size() / 1024) << " KiB" << Qt::endl;
+    return ok;
+}
+
+static QDomElement childElement(const QDomElement &parent, const QString &name)
+{
+    QDomElement child = parent.firstChildElement();
+    while(child.isElement() && child.tagName() != name)
+        child = child.nextSiblingElement();
+    return child;
+}
+
+/* The former KnxBus::_parseKnxProj(): 0.xml inflated in one buffer, then a DOM */
+static int parseDom(const QString &path)
+{
+    unzFile zip = unzOpen64(path.toStdString().c_str());
+    if(zip == NULL)
+        return -1;
+    QDomDocument doc;
+    int ret = unzGoToFirstFile(zip);
+    while(ret == UNZ_OK)
+    {
+        char fn[512];
+        unz_file_info64 info;
+        unzGetCurrentFileInfo64(zip, &info, fn, sizeof(fn), NULL, 0, NULL, 0);
+        if(QByteArray(fn).endsWith("/0.xml") && unzOpenCurrentFile(zip) == UNZ_OK)
+        {
+            char *buffer = static_cast<char *>(malloc(info.uncompressed_size + 1));
+            unzReadCurrentFile(zip, buffer, static_cast<unsigned>(info.uncompressed_size + 1));
+            QByteArray data(buffer, static_cast<qsizetype>(info.uncompressed_size));
+            doc.setContent(data);
+            free(buffer);
+            unzCloseCurrentFile(zip);
+            break;
+        }
+        ret = unzGoToNextFile(zip);
+    }
+    unzClose(zip);
+
+    QList<QPair<quint16, QString>> addresses;
+    const QDomElement installation = childElement(childElement(childElement(doc.documentElement(), "Project"), "Installations"), "Installation");
+    const QDomElement groupRanges = childElement(childElement(installation, "GroupAddresses"), "GroupRanges");
+    for(QDomElement l1 = groupRanges.firstChildElement("GroupRange"); !l1.isNull(); l1 = l1.nextSiblingElement("GroupRange"))
+    {
+        for(QDomElement l2 = l1.firstChildElement("GroupRange"); !l2.isNull(); l2 = l2.nextSiblingElement("GroupRange"))
+        {
+            for(QDomElement ga = l2.firstChildElement("GroupAddress"); !ga.isNull(); ga = ga.nextSiblingElement("GroupAddress"))
+            {
+                const QString id = l1.attribute("Name").trimmed() + "." + l2.attribute("Name").trimmed() + "." + ga.attribute("Name").trimmed();
+                addresses.append({static_cast<quint16>(ga.attribute("Address").toInt()), id});
+            }
+        }
+    }
+    return addresses.size();
+}
+
+static int parseStream(const QString &path)
+{
+    KnxProjReader reader(path);
+    if(!reader.read())
+        out << reader.errorString() << Qt::endl;
+    return reader.groupAddresses().size();
+}
+
+static int run(const QString &mode, const QString &path)
+{
+    const long before = peakRssKiB();
+    QElapsedTimer timer;
+    timer.start();
+    const int count = (mode == QLatin1String("dom")) ? parseDom(path) : parseStream(path);
+    const qint64 elapsed = timer.elapsed();
+    out << mode.leftJustified(8) << count << " group addresses, " << elapsed << " ms, peak RSS +"
+        << (peakRssKiB() - before) / 1024 << " MiB" << Qt::endl;
+    return count == MainGroups * MiddleGroups * SubGroups ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    if(args.size() == 3)
+        return run(args[1], args[2]);
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath("bench.knxproj");
+    if(!generate(path))
+    {
+        out << "Can't write " << path << Qt::endl;
+        return 1;
+    }
+
+    int ret = 0;
+    for(const char *mode: { "dom", "stream" })
+    {
+        QProcess process;
+        process.setProcessChannelMode(QProcess::ForwardedChannels);
+        process.start(app.applicationFilePath(), { QString::fromLatin1(mode), path });
+        process.waitForFinished(-1);
+        ret |= process.exitCode();
+    }
+    return ret;
+}
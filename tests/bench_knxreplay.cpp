@@ -0,0 +1,154 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <ctime>
+#include "knxconnection.h"
+#include "knxdpt.h"
+#include "knxtelegram.h"
+
+/* Replay throughput of the receive path without knxd.
+ *
+ *   bench_knxreplay [trace] [speed]
+ *
+ * Without a trace, 200,000 telegrams on 3,000 group addresses (DPT 1 and
+ * 9) are generated. The trace goes through KnxReplayTransport and
+ * KnxConnection on an I/O thread as on a live bus, the main thread decodes
+ * every telegram. Reports telegrams/s, process CPU per telegram and the
+ * latency from the socket read to the decoded value. */
+
+static constexpr int GroupAddresses = 3000;
+static constexpr int Telegrams = 200000;
+
+static QTextStream out(stdout);
+
+static qint64 cpuTimestamp()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/* DPT 1.001 on even group addresses, DPT 9.001 on odd ones */
+static quint16 groupAddress(int i)
+{
+    return static_cast<quint16>(((i / 256) << 8) | (i % 256));
+}
+
+static quint16 dptOf(quint16 gad)
+{
+    return (gad & 1) ? 0x0901 : 0x0101;
+}
+
+static bool generate(const QString &path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream trace(&file);
+    trace << "# bench_knxreplay synthetic trace\n";
+    for(int i = 0; i < Telegrams; i++)
+    {
+        const quint16 gad = groupAddress((i * 7919) % GroupAddresses);
+        QString apdu;
+        if(dptOf(gad) == 0x0101)
+            apdu = (i & 2) ? QStringLiteral("0081") : QStringLiteral("0080");
+        else
+            apdu = QStringLiteral("0080%1").arg(0x0C00 + (i % 512), 4, 16, QLatin1Char('0'));
+        trace << (i * 0.1) << " 1.1." << (1 + i % 200) << ' ' << ((gad >> 11) & 0x1F) << '/' << ((gad >> 8) & 0x07) << '/'
+              << (gad & 0xFF) << ' ' << apdu << '\n';
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+
+    QTemporaryDir dir;
+    QString path = (args.size() > 1) ? args[1] : dir.filePath("bench.trace");
+    if(args.size() <= 1 && !generate(path))
+    {
+        out << "Can't write " << path << Qt::endl;
+        return 1;
+    }
+    const QString speed = (args.size() > 2) ? args[2] : QStringLiteral("max");
+
+    QList<const KnxDptCodec *> codecs(65536, nullptr);
+    for(int i = 0; i < GroupAddresses; i++)
+        codecs[groupAddress(i)] = knxDptCodec(dptOf(groupAddress(i)));
+
+    QThread thread;
+    KnxConnection *connection = new KnxConnection(QStringLiteral("replay:%1?speed=%2").arg(path, speed));
+    connection->moveToThread(&thread);
+
+    QList<qint64> latencies;
+    latencies.reserve(Telegrams);
+    QList<KnxValue> values(65536);
+    quint64 changes = 0;
+    auto drain = [connection, &codecs, &latencies, &values, &changes]() {
+        connection->acknowledgeTelegrams();
+        KnxTelegram telegram;
+        while(connection->takeTelegram(telegram))
+        {
+            const KnxDptCodec *codec = codecs[telegram.dest];
+            if(codec && telegram.len >= knxDptFrameSize(codec))
+            {
+                KnxValue value;
+                codec->decode(telegram.frame + 1, value);
+                KnxValue &current = values[telegram.dest];
+                if(value != current)
+                {
+                    current = value;
+                    changes++;
+                }
+            }
+            latencies.append(knxTimestamp() - telegram.timestamp);
+        }
+    };
+
+    QElapsedTimer wall;
+    qint64 cpuStart = 0;
+    QObject::connect(connection, &KnxConnection::telegramsReady, &app, drain);
+    QObject::connect(connection, &KnxConnection::finished, &app, [&]() {
+        drain();
+        app.quit();
+    });
+
+    thread.start();
+    wall.start();
+    cpuStart = cpuTimestamp();
+    QMetaObject::invokeMethod(connection, &KnxConnection::open, Qt::QueuedConnection);
+    app.exec();
+    const qint64 elapsed = wall.nsecsElapsed();
+    const qint64 cpu = cpuTimestamp() - cpuStart;
+
+    QMetaObject::invokeMethod(connection, &KnxConnection::close, Qt::BlockingQueuedConnection);
+    thread.quit();
+    thread.wait();
+    const quint64 overflow = connection->rxOverflow();
+    delete connection;
+
+    if(latencies.isEmpty())
+    {
+        out << "No telegram replayed from " << path << Qt::endl;
+        return 1;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double fraction) {
+        return latencies[qMin(latencies.size() - 1, static_cast<qsizetype>(fraction * latencies.size()))] / 1000.0;
+    };
+    const qsizetype count = latencies.size();
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(2);
+    out << count << " telegrams (" << changes << " value changes, " << overflow << " dropped) in "
+        << elapsed / 1000000.0 << " ms at speed " << speed << Qt::endl;
+    out << "  " << count * 1e9 / elapsed << " telegrams/s, " << static_cast<double>(cpu) / count << " ns CPU per telegram" << Qt::endl;
+    out << "  latency p50 " << percentile(0.5) << " us, p99 " << percentile(0.99) << " us, max " << latencies.last() / 1000.0
+        << " us" << Qt::endl;
+    return 0;
+}
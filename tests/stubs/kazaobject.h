@@ -0,0 +1,38 @@
+#ifndef KAZAOBJECT_H
+#define KAZAOBJECT_H
+
+#include <QObject>
+#include <QString>
+#include <QVariant>
+
+/* Stand-in for the KaZa server object base class, so KnxObject can be
+ * linked into the tests without the server. Only what KnxObject uses. */
+class KaZaObject : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit KaZaObject(const QString &name, QObject *parent = nullptr)
+        : QObject{parent}
+        , m_name(name)
+    {
+    }
+
+    QString name() const { return m_name; }
+    QString unit() const { return m_unit; }
+    void setUnit(const QString &unit) { m_unit = unit; }
+
+    virtual QVariant value() const = 0;
+    virtual void setValue(QVariant newValue) = 0;
+    virtual void changeValue(QVariant newValue, bool confirm = false) = 0;
+    virtual QVariant rawid() const = 0;
+
+signals:
+    void valueChanged();
+
+private:
+    QString m_name;
+    QString m_unit;
+};
+
+#endif // KAZAOBJECT_H
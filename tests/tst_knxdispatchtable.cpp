@@ -0,0 +1,88 @@
+#include <QTest>
+#include "knxdispatchtable.h"
+
+static KnxObject *fakeObject(quintptr id)
+{
+    return reinterpret_cast<KnxObject*>(id << 4);
+}
+
+class TestKnxDispatchTable : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void emptyTable();
+    void insertAndLookup();
+    void replaceObject();
+    void clear();
+    void notManaged();
+};
+
+void TestKnxDispatchTable::emptyTable()
+{
+    KnxDispatchTable table;
+    for(int gad = 0; gad < 65536; gad++)
+        QVERIFY(table.object(static_cast<quint16>(gad)) == nullptr);
+    QCOMPARE(table.size(), 0);
+    QCOMPARE(table.notManagedCount(), 0);
+}
+
+void TestKnxDispatchTable::insertAndLookup()
+{
+    KnxDispatchTable table;
+    /* Every main/middle page, first and last sub of each */
+    for(int page = 0; page < 256; page++)
+    {
+        table.insert(static_cast<quint16>(page << 8), fakeObject(page << 8 | 1));
+        table.insert(static_cast<quint16>(page << 8 | 0xFF), fakeObject(page << 8 | 0xFF));
+    }
+    QCOMPARE(table.size(), 512);
+    for(int gad = 0; gad < 65536; gad++)
+    {
+        const int sub = gad & 0xFF;
+        if(sub == 0)
+            QCOMPARE(table.object(static_cast<quint16>(gad)), fakeObject(gad | 1));
+        else if(sub == 0xFF)
+            QCOMPARE(table.object(static_cast<quint16>(gad)), fakeObject(gad));
+        else
+            QVERIFY(table.object(static_cast<quint16>(gad)) == nullptr);
+    }
+}
+
+void TestKnxDispatchTable::replaceObject()
+{
+    KnxDispatchTable table;
+    table.insert(0x0801, fakeObject(1));
+    table.insert(0x0801, fakeObject(2));
+    QCOMPARE(table.object(0x0801), fakeObject(2));
+    QCOMPARE(table.size(), 1);
+    QVERIFY(!table.objects().contains(fakeObject(1)));
+}
+
+void TestKnxDispatchTable::clear()
+{
+    KnxDispatchTable table;
+    table.insert(0x0801, fakeObject(1));
+    table.markNotManaged(0x0802);
+    table.clear();
+    QVERIFY(table.object(0x0801) == nullptr);
+    QVERIFY(!table.isNotManaged(0x0802));
+    QCOMPARE(table.size(), 0);
+    QCOMPARE(table.notManagedCount(), 0);
+}
+
+void TestKnxDispatchTable::notManaged()
+{
+    KnxDispatchTable table;
+    QVERIFY(table.markNotManaged(0x0000));
+    QVERIFY(table.markNotManaged(0xFFFF));
+    QVERIFY(!table.markNotManaged(0xFFFF));
+    QVERIFY(table.isNotManaged(0x0000));
+    QVERIFY(table.isNotManaged(0xFFFF));
+    QVERIFY(!table.isNotManaged(0x0001));
+    QCOMPARE(table.notManagedCount(), 2);
+}
+
+QTEST_APPLESS_MAIN(TestKnxDispatchTable)
+
+#include "tst_knxdispatchtable.moc"
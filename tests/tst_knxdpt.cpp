@@ -0,0 +1,207 @@
+#include <QTest>
+#include <QColor>
+#include <QDate>
+#include <QRandomGenerator>
+#include <QTime>
+#include <QVariantMap>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "knxdpt.h"
+
+/* APCI low bits in data[0] of a GroupValueWrite and a GroupValueResponse */
+static const unsigned char s_apci[] = { 0x80, 0x40 };
+
+static int encode9(float value)
+{
+    unsigned char data[3] = {};
+    encode_dpt9(data, value);
+    return data[1] << 8 | data[2];
+}
+
+static float decode9(int code)
+{
+    const unsigned char data[3] = { 0, static_cast<unsigned char>(code >> 8), static_cast<unsigned char>(code) };
+    float value;
+    decode_dpt9(data, &value);
+    return value;
+}
+
+/* Value of a DPT 9 code in hundredths */
+static qint64 hundredths9(int code)
+{
+    const qint64 mant = (code & 0x07ff) - ((code & 0x8000) >> 4);
+    return mant << ((code >> 11) & 0x0f);
+}
+
+/* Encoding of a value with the smallest exponent, -1 if none */
+static int canonical9(qint64 hundredths)
+{
+    for(int exp = 0; exp < 16; exp++)
+    {
+        if(hundredths % (Q_INT64_C(1) << exp))
+            break;
+        const qint64 mant = hundredths >> exp;
+        if(mant >= -2048 && mant <= 2047)
+            return static_cast<int>(((mant & 0x800) << 4) | (exp << 11) | (mant & 0x7ff));
+    }
+    return -1;
+}
+
+class TestKnxDpt : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void rawRoundTrip_data();
+    void rawRoundTrip();
+    void dpt9RoundTrip();
+    void dpt9Nearest();
+    void dpt9Specials();
+
+private:
+    std::vector<qint64> m_grid9;
+    qint64 _nearest9(float value);
+};
+
+void TestKnxDpt::rawRoundTrip_data()
+{
+    QTest::addColumn<quint16>("dpt");
+    QTest::addColumn<QVariant>("value");
+
+    QVariantMap speed;
+    speed["period"] = 1200;
+    speed["percent"] = 40;
+
+    QTest::newRow("4.001") << quint16(0x0401) << QVariant(QStringLiteral("K"));
+    QTest::newRow("10.001") << quint16(0x0A01) << QVariant(QTime(23, 59, 7));
+    QTest::newRow("11.001") << quint16(0x0B01) << QVariant(QDate(2024, 2, 29));
+    QTest::newRow("16.000") << quint16(0x1000) << QVariant(QStringLiteral("KNX string 14"));
+    QTest::newRow("225.001") << quint16(0xE101) << QVariant(speed);
+    QTest::newRow("232.600") << quint16(0xE800) << QVariant(QColor(12, 200, 255));
+}
+
+/* A value written, then received as a write or read back as a response,
+ * must compare equal: write confirmation and change suppression rely on it */
+void TestKnxDpt::rawRoundTrip()
+{
+    QFETCH(quint16, dpt);
+    QFETCH(QVariant, value);
+
+    const KnxDptCodec *codec = knxDptCodec(dpt);
+    QVERIFY(codec != nullptr);
+
+    KnxValue written;
+    QVERIFY(knxDptFromVariant(codec, value, written));
+    QVERIFY(written.kind == KnxValue::Raw);
+
+    for(unsigned char apci: s_apci)
+    {
+        unsigned char data[KNX_DPT_MAX_SIZE + 1] = {};
+        data[0] = apci;
+        QVERIFY(codec->encode(value, data));
+
+        KnxValue received;
+        codec->decode(data, received);
+        QVERIFY(received == written);
+
+        KnxValue again;
+        QVERIFY(knxDptFromVariant(codec, codec->toVariant(received), again));
+        QVERIFY(again == received);
+    }
+}
+
+/* Every code decodes to a value that encodes back to its canonical code */
+void TestKnxDpt::dpt9RoundTrip()
+{
+    for(int code = 0; code < 65536; code++)
+    {
+        const int expected = canonical9(hundredths9(code));
+        const int encoded = encode9(decode9(code));
+        if(encoded != expected)
+            QFAIL(qPrintable(QStringLiteral("Code %1 encodes back to %2 instead of %3")
+                                 .arg(code, 4, 16, QLatin1Char('0')).arg(encoded, 4, 16, QLatin1Char('0')).arg(expected, 4, 16, QLatin1Char('0'))));
+    }
+}
+
+/* Nearest representable value, ties to the even mantissa of the grid around
+ * it, out of range clamped */
+qint64 TestKnxDpt::_nearest9(float value)
+{
+    if(m_grid9.empty())
+    {
+        for(int code = 0; code < 65536; code++)
+            m_grid9.push_back(hundredths9(code));
+        std::sort(m_grid9.begin(), m_grid9.end());
+        m_grid9.erase(std::unique(m_grid9.begin(), m_grid9.end()), m_grid9.end());
+    }
+    const double x = qBound(-2048.0 * 32768.0, static_cast<double>(value) * 100.0, 2047.0 * 32768.0);
+    const auto it = std::lower_bound(m_grid9.begin(), m_grid9.end(), static_cast<qint64>(std::ceil(x)));
+    const qint64 hi = *it;
+    const qint64 lo = (it == m_grid9.begin()) ? hi : *(it - 1);
+    if(hi == x || x - lo > hi - x)
+        return hi;
+    if(x - lo < hi - x)
+        return lo;
+    const qint64 spacing = hi - lo;
+    return ((lo / spacing) % 2 == 0) ? lo : hi;
+}
+
+void TestKnxDpt::dpt9Nearest()
+{
+    auto check = [this](float value) {
+        const int code = encode9(value);
+        return hundredths9(code) == _nearest9(value) && code == canonical9(hundredths9(code));
+    };
+
+    /* Every midpoint between two representable values and its neighbours */
+    if(m_grid9.empty())
+        _nearest9(0.0f);
+    const std::vector<qint64> grid = m_grid9;
+    for(size_t i = 0; i + 1 < grid.size(); i++)
+    {
+        const float mid = static_cast<float>((grid[i] + grid[i + 1]) / 200.0);
+        const float exact = static_cast<float>(grid[i] / 100.0);
+        for(float value: { mid, std::nextafter(mid, 1e9f), std::nextafter(mid, -1e9f), exact })
+        {
+            if(!check(value))
+                QFAIL(qPrintable(QStringLiteral("%1 encoded to %2").arg(double(value), 0, 'g', 9).arg(encode9(value), 4, 16, QLatin1Char('0'))));
+        }
+    }
+
+    /* Sensor range and full range */
+    QRandomGenerator rng(24);
+    for(int i = 0; i < 1000000; i++)
+    {
+        const float values[] = { static_cast<float>(rng.bounded(60.0) - 30.0), static_cast<float>(rng.bounded(1400000.0) - 700000.0) };
+        for(float value: values)
+        {
+            if(!check(value))
+                QFAIL(qPrintable(QStringLiteral("%1 encoded to %2").arg(double(value), 0, 'g', 9).arg(encode9(value), 4, 16, QLatin1Char('0'))));
+        }
+    }
+}
+
+void TestKnxDpt::dpt9Specials()
+{
+    QCOMPARE(encode9(0.0f), 0x0000);
+    QCOMPARE(encode9(-0.0f), 0x0000);
+    QCOMPARE(encode9(0.005f), 0x0000);
+    QCOMPARE(encode9(20.47f), 0x07FF);
+    QCOMPARE(encode9(20.475f), 0x0C00);
+    QCOMPARE(encode9(-20.48f), 0x8000);
+    QCOMPARE(encode9(-20.485f), 0x8000);
+    /* Out of range is clamped. The largest value shares its code with
+     * invalid data, which is what NaN encodes to */
+    QCOMPARE(encode9(670760.96f), 0x7FFF);
+    QCOMPARE(encode9(-671088.64f), 0xF800);
+    QCOMPARE(encode9(1e30f), 0x7FFF);
+    QCOMPARE(encode9(std::numeric_limits<float>::infinity()), 0x7FFF);
+    QCOMPARE(encode9(-std::numeric_limits<float>::infinity()), 0xF800);
+    QCOMPARE(encode9(std::numeric_limits<float>::quiet_NaN()), 0x7FFF);
+}
+
+QTEST_APPLESS_MAIN(TestKnxDpt)
+
+#include "tst_knxdpt.moc"
@@ -0,0 +1,108 @@
+#include <QTest>
+#include <QRandomGenerator>
+#include <vector>
+#include "knxdpt.h"
+#include "knxdptbatch.h"
+
+/* The batched kernels must be bit-exact with decode_dpt9() and
+ * decode_dpt14(). ctest runs this test once per kernel through
+ * KNX_DPT_KERNEL. */
+
+class TestKnxDptBatch : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void dpt9AllCodes();
+    void dpt9Tails();
+    void dpt14();
+};
+
+void TestKnxDptBatch::initTestCase()
+{
+    const QByteArray forced = qgetenv("KNX_DPT_KERNEL");
+    if(!forced.isEmpty() && forced != knxDptBatchKernel())
+        QSKIP("Kernel not available on this CPU");
+    qInfo() << "Kernel" << knxDptBatchKernel();
+}
+
+void TestKnxDptBatch::dpt9AllCodes()
+{
+    std::vector<unsigned char> payloads(2 * 65536);
+    for(int code = 0; code < 65536; code++)
+    {
+        payloads[2 * code] = static_cast<unsigned char>(code >> 8);
+        payloads[2 * code + 1] = static_cast<unsigned char>(code);
+    }
+    std::vector<float> values(65536);
+    knxDecodeDpt9(payloads.data(), values.data(), 65536);
+
+    for(int code = 0; code < 65536; code++)
+    {
+        const unsigned char data[3] = { 0x80, static_cast<unsigned char>(code >> 8), static_cast<unsigned char>(code) };
+        float expected;
+        decode_dpt9(data, &expected);
+        if(memcmp(&expected, &values[code], sizeof(float)) != 0)
+            QFAIL(qPrintable(QStringLiteral("DPT 9 code %1: %2 instead of %3").arg(code, 4, 16, QLatin1Char('0')).arg(values[code]).arg(expected)));
+    }
+}
+
+/* Unaligned input and every count below two vectors, so the scalar tail is used */
+void TestKnxDptBatch::dpt9Tails()
+{
+    unsigned char payloads[2 * 33 + 1];
+    for(size_t i = 0; i < sizeof(payloads); i++)
+        payloads[i] = static_cast<unsigned char>(i * 37 + 11);
+
+    for(int count = 0; count <= 32; count++)
+    {
+        float values[33];
+        values[count] = 1.5f;
+        knxDecodeDpt9(payloads + 1, values, count);
+        QCOMPARE(values[count], 1.5f);
+        for(int i = 0; i < count; i++)
+        {
+            const unsigned char data[3] = { 0x80, payloads[1 + 2 * i], payloads[2 + 2 * i] };
+            float expected;
+            decode_dpt9(data, &expected);
+            QVERIFY(memcmp(&expected, &values[i], sizeof(float)) == 0);
+        }
+    }
+}
+
+void TestKnxDptBatch::dpt14()
+{
+    constexpr int Count = 100003;
+    QRandomGenerator rng(14);
+    std::vector<quint32> bits(Count);
+    rng.fillRange(bits.data(), bits.size());
+    /* Specials: zeros, infinities, NaN, denormals */
+    const quint32 specials[] = { 0x00000000, 0x80000000, 0x7F800000, 0xFF800000, 0x7FC00000, 0x00000001, 0x807FFFFF };
+    memcpy(bits.data(), specials, sizeof(specials));
+
+    std::vector<unsigned char> payloads(4 * Count);
+    for(int i = 0; i < Count; i++)
+    {
+        payloads[4 * i] = static_cast<unsigned char>(bits[i] >> 24);
+        payloads[4 * i + 1] = static_cast<unsigned char>(bits[i] >> 16);
+        payloads[4 * i + 2] = static_cast<unsigned char>(bits[i] >> 8);
+        payloads[4 * i + 3] = static_cast<unsigned char>(bits[i]);
+    }
+    std::vector<float> values(Count);
+    knxDecodeDpt14(payloads.data(), values.data(), Count);
+
+    for(int i = 0; i < Count; i++)
+    {
+        unsigned char data[5] = { 0x80 };
+        memcpy(data + 1, &payloads[4 * i], 4);
+        float expected;
+        decode_dpt14(data, &expected);
+        if(memcmp(&expected, &values[i], sizeof(float)) != 0)
+            QFAIL(qPrintable(QStringLiteral("DPT 14 payload %1 differs").arg(bits[i], 8, 16, QLatin1Char('0'))));
+    }
+}
+
+QTEST_APPLESS_MAIN(TestKnxDptBatch)
+
+#include "tst_knxdptbatch.moc"
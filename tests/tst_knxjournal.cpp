@@ -0,0 +1,95 @@
+#include <QTest>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include "knxjournal.h"
+#include "knxtelegram.h"
+
+class TestKnxJournal : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void writeAndRead();
+    void segmentsOfLink();
+    void tornRecord();
+};
+
+void TestKnxJournal::writeAndRead()
+{
+    QTemporaryDir dir;
+    const unsigned char writeFrame[] = { 0x00, 0x80, 0x0C, 0x1A };
+    const unsigned char readFrame[] = { 0x00, 0x00 };
+    {
+        KnxJournal journal;
+        journal.setSyncInterval(-1);
+        QVERIFY(journal.open(dir.path(), QStringLiteral("link0")));
+        for(int i = 0; i < 1000; i++)
+        {
+            const bool transmit = i % 10 == 0;
+            journal.record(knxTimestamp(), 0x1101, static_cast<quint16>(i), transmit, transmit ? readFrame : writeFrame,
+                           transmit ? sizeof(readFrame) : sizeof(writeFrame));
+        }
+        journal.close();
+        QCOMPARE(journal.records(), quint64(1000));
+    }
+
+    const QStringList segments = KnxJournal::segments(dir.path(), QStringLiteral("link0"));
+    QCOMPARE(segments.size(), 1);
+    KnxJournalReader reader;
+    QVERIFY2(reader.open(segments.first()), qPrintable(reader.errorString()));
+    QCOMPARE(reader.size(), qsizetype(1000));
+    for(qsizetype i = 0; i < reader.size(); i++)
+    {
+        const KnxJournal::Record &record = reader.record(i);
+        const bool transmit = i % 10 == 0;
+        QCOMPARE(record.src, quint16(0x1101));
+        QCOMPARE(record.dest, quint16(i));
+        QCOMPARE(bool(record.flags & KnxJournal::Transmit), transmit);
+        QCOMPARE(record.apci, quint8(transmit ? 0x00 : 0x02));   // GroupValueRead, GroupValueWrite
+        QCOMPARE(int(record.len), transmit ? int(sizeof(readFrame)) : int(sizeof(writeFrame)));
+        if(i > 0)
+            QVERIFY(record.timestamp >= reader.record(i - 1).timestamp);
+    }
+}
+
+void TestKnxJournal::segmentsOfLink()
+{
+    QTemporaryDir dir;
+    const unsigned char frame[] = { 0x00, 0x81 };
+    for(const char *name: { "link1", "link10", "link2" })
+    {
+        KnxJournal journal;
+        QVERIFY(journal.open(dir.path(), QString::fromLatin1(name)));
+        journal.record(knxTimestamp(), 0x1101, 0x0801, false, frame, sizeof(frame));
+    }
+
+    const QStringList segments = KnxJournal::segments(dir.path(), QStringLiteral("link1"));
+    QCOMPARE(segments.size(), 1);
+    QVERIFY(QFileInfo(segments.first()).fileName().startsWith(QLatin1String("link1-")));
+    QVERIFY(KnxJournal::segments(dir.path(), QStringLiteral("link3")).isEmpty());
+}
+
+void TestKnxJournal::tornRecord()
+{
+    QTemporaryDir dir;
+    const unsigned char frame[] = { 0x00, 0x81 };
+    {
+        KnxJournal journal;
+        QVERIFY(journal.open(dir.path(), QStringLiteral("link0")));
+        for(int i = 0; i < 3; i++)
+            journal.record(knxTimestamp(), 0x1101, 0x0801, false, frame, sizeof(frame));
+    }
+
+    /* Power lost in the middle of the last record */
+    const QString path = KnxJournal::segments(dir.path(), QStringLiteral("link0")).first();
+    QFile file(path);
+    QVERIFY(file.resize(file.size() - 7));
+
+    KnxJournalReader reader;
+    QVERIFY(reader.open(path));
+    QCOMPARE(reader.size(), qsizetype(2));
+}
+
+QTEST_APPLESS_MAIN(TestKnxJournal)
+
+#include "tst_knxjournal.moc"
@@ -0,0 +1,206 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <limits>
+#include "knxdispatchtable.h"
+#include "knxdptbatch.h"
+#include "knxhistory.h"
+#include "knxlogging.h"
+#include "knxmetrics.h"
+#include "knxobject.h"
+#include "knxreadmanager.h"
+#include "knxreadscheduler.h"
+#include "knxreceiver.h"
+#include "knxsnapshot.h"
+#include "knxspscring.h"
+#include "knxtelegram.h"
+
+/* Heap allocations on the receive path, from the telegram handed over by
+ * the I/O thread to valueChanged: KnxReceiver::handle() with the metrics,
+ * read scheduler, snapshot, history and read manager of the bus, then
+ * KnxObject::reciveFrame() and a connected receiver reading the new value.
+ * malloc is interposed so Qt containers are counted too. */
+
+#ifdef __GLIBC__
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+
+static bool s_counting = false;
+static int s_allocations = 0;
+
+extern "C" void *malloc(size_t size)
+{
+    s_allocations += s_counting;
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    s_allocations += s_counting;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+    s_allocations += s_counting;
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+class TestKnxReceivePath : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void zeroAllocation_data();
+    void zeroAllocation();
+    void batchedValue_data();
+    void batchedValue();
+};
+
+void TestKnxReceivePath::zeroAllocation_data()
+{
+    QTest::addColumn<quint16>("dpt");
+    QTest::addColumn<QByteArray>("first");
+    QTest::addColumn<QByteArray>("second");
+
+    /* Two GroupValueWrite frames with different values */
+    QTest::newRow("1.001") << quint16(0x0101) << QByteArray::fromHex("0081") << QByteArray::fromHex("0080");
+    QTest::newRow("5.001") << quint16(0x0501) << QByteArray::fromHex("00807f") << QByteArray::fromHex("008080");
+    QTest::newRow("7.001") << quint16(0x0701) << QByteArray::fromHex("00801234") << QByteArray::fromHex("00801235");
+    QTest::newRow("9.001") << quint16(0x0901) << QByteArray::fromHex("00800c1a") << QByteArray::fromHex("00800c1b");
+    QTest::newRow("12.001") << quint16(0x0C01) << QByteArray::fromHex("008012345678") << QByteArray::fromHex("008012345679");
+    QTest::newRow("13.010") << quint16(0x0D0A) << QByteArray::fromHex("0080fffffc18") << QByteArray::fromHex("0080fffffc19");
+    QTest::newRow("14.056") << quint16(0x0E38) << QByteArray::fromHex("0080447a0000") << QByteArray::fromHex("0080447b0000");
+}
+
+void TestKnxReceivePath::zeroAllocation()
+{
+#ifndef __GLIBC__
+    QSKIP("malloc interposition needs glibc");
+#else
+    QFETCH(quint16, dpt);
+    QFETCH(QByteArray, first);
+    QFETCH(QByteArray, second);
+
+    QVERIFY(!lcKnxFrame().isDebugEnabled());
+    constexpr quint16 gad = 0x0A01;
+
+    KnxDispatchTable objects;
+    KnxMetrics metrics;
+    KnxReadScheduler readScheduler;
+    KnxReadManager readManager;
+    KnxSnapshot snapshot;
+    KnxHistory history;
+    KnxReceiver receiver(objects, metrics, readScheduler, readManager, snapshot, history);
+
+    KnxObject object(QStringLiteral("test.receive"), gad, dpt);
+    QVERIFY(object.codec() != nullptr);
+    objects.insert(gad, &object);
+
+    QTemporaryDir dir;
+    QVERIFY(snapshot.open(dir.filePath("snapshot")));
+    snapshot.reserve(objects.size());
+    history.setup(64, { gad }, { object.codec()->size });
+
+    /* A startup read and a read waiter, completed by the first response */
+    readScheduler.enqueue(gad);
+    bool answered = false;
+    readManager.read(gad, [&answered](bool ok) { answered = ok; });
+
+    int changes = 0;
+    QVariant received;
+    QObject::connect(&object, &KnxObject::valueChanged, &object, [&]() {
+        received = object.value();
+        changes++;
+    });
+    QCOMPARE(object.observers(), 1);
+
+    static KnxSpscRing<KnxTelegram, 256> ring;
+    auto receive = [&](int count) {
+        KnxTelegram in {};
+        in.src = 0x1101;
+        for(int i = 0; i < count; i++)
+        {
+            /* The value changes with every telegram, and every third one is
+             * followed by a telegram on an unmanaged address */
+            const QByteArray &frame = (i & 1) ? second : first;
+            in.len = static_cast<quint8>(frame.size());
+            memcpy(in.frame, frame.constData(), frame.size());
+            in.dest = gad;
+            in.timestamp = knxTimestamp();
+            ring.push(in);
+            if(i % 3 == 0)
+            {
+                in.dest = 0x0A02;
+                ring.push(in);
+            }
+
+            KnxTelegram telegram;
+            while(ring.pop(telegram))
+                receiver.handle(telegram.src, telegram.dest, telegram.frame, telegram.len);
+        }
+    };
+
+    /* First telegrams insert the snapshot record and mark the unknown address */
+    receive(2);
+    QVERIFY(answered);
+    QCOMPARE(readScheduler.pending(), 0);
+
+    const quint64 propagated = receiver.propagated();
+    const quint64 unknown = metrics.unknownTelegrams();
+    changes = 0;
+    s_allocations = 0;
+    s_counting = true;
+    receive(10000);
+    s_counting = false;
+
+    QCOMPARE(changes, 10000);
+    QCOMPARE(receiver.propagated() - propagated, quint64(changes));
+    QCOMPARE(metrics.unknownTelegrams() - unknown, quint64(3334));
+    QVERIFY(received.isValid());
+    QVERIFY(snapshot.record(gad) != nullptr);
+    QVERIFY(!history.range(gad, 0, std::numeric_limits<qint64>::max()).isEmpty());
+    QCOMPARE(s_allocations, 0);
+#endif
+}
+
+void TestKnxReceivePath::batchedValue_data()
+{
+    QTest::addColumn<quint16>("dpt");
+    QTest::addColumn<QByteArray>("frame");
+
+    QTest::newRow("9.001") << quint16(0x0901) << QByteArray::fromHex("00800c1a");
+    QTest::newRow("9.001 negative") << quint16(0x0901) << QByteArray::fromHex("0080f860");
+    QTest::newRow("14.056") << quint16(0x0E38) << QByteArray::fromHex("0080447a0000");
+}
+
+/* A snapshot restored through the float kernels gives the objects the
+ * value reciveFrame() decodes */
+void TestKnxReceivePath::batchedValue()
+{
+    QFETCH(quint16, dpt);
+    QFETCH(QByteArray, frame);
+
+    KnxObject received(QStringLiteral("test.frame"), 0x0A01, dpt);
+    KnxObject restored(QStringLiteral("test.batch"), 0x0A01, dpt);
+    QVERIFY(received.reciveFrame(reinterpret_cast<unsigned char *>(frame.data()), frame.size()) == KnxObject::Propagated);
+
+    const unsigned char *payload = reinterpret_cast<const unsigned char *>(frame.constData()) + 2;
+    float decoded;
+    if((dpt >> 8) == 9)
+        knxDecodeDpt9(payload, &decoded, 1);
+    else
+        knxDecodeDpt14(payload, &decoded, 1);
+    KnxValue value;
+    value.kind = KnxValue::Float;
+    value.f = decoded;
+    QVERIFY(restored.reciveValue(value) == KnxObject::Propagated);
+
+    QVERIFY(restored.latestValue() == received.latestValue());
+    QCOMPARE(restored.value(), received.value());
+}
+
+QTEST_GUILESS_MAIN(TestKnxReceivePath)
+
+#include "tst_knxreceivepath.moc"
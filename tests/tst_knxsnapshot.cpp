@@ -0,0 +1,80 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include "knxsnapshot.h"
+
+class TestKnxSnapshot : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void storeAndReopen();
+    void rejectInvalidLength();
+    void resetOversizedCount();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+void TestKnxSnapshot::storeAndReopen()
+{
+    const QString path = m_dir.filePath("store.knxs");
+    const unsigned char frame[] = { 0x00, 0x80, 0x0C, 0x1A };
+    {
+        KnxSnapshot snapshot;
+        QVERIFY(snapshot.open(path));
+        /* Past the initial capacity to go through a remap */
+        for(int gad = 0; gad < 100; gad++)
+            snapshot.store(static_cast<quint16>(gad), 0x0901, frame, sizeof(frame), gad);
+        QCOMPARE(snapshot.size(), 100);
+    }
+
+    KnxSnapshot snapshot;
+    QVERIFY(snapshot.open(path));
+    QCOMPARE(snapshot.size(), 100);
+    const KnxSnapshot::Record *rec = snapshot.record(42);
+    QVERIFY(rec != nullptr);
+    QCOMPARE(rec->dpt, quint16(0x0901));
+    QCOMPARE(rec->timestamp, qint64(42));
+    QCOMPARE(int(rec->len), int(sizeof(frame)));
+    QVERIFY(memcmp(rec->frame, frame, sizeof(frame)) == 0);
+}
+
+void TestKnxSnapshot::rejectInvalidLength()
+{
+    KnxSnapshot snapshot;
+    QVERIFY(snapshot.open(m_dir.filePath("length.knxs")));
+    unsigned char frame[KnxSnapshot::MaxFrameSize + 1] = {};
+    snapshot.store(1, 0x0101, frame, 1, 0);
+    snapshot.store(2, 0x1000, frame, KnxSnapshot::MaxFrameSize + 1, 0);
+    QCOMPARE(snapshot.size(), 0);
+    QVERIFY(snapshot.record(1) == nullptr);
+    QVERIFY(snapshot.record(2) == nullptr);
+}
+
+void TestKnxSnapshot::resetOversizedCount()
+{
+    const QString path = m_dir.filePath("oversized.knxs");
+    const unsigned char frame[] = { 0x00, 0x81 };
+    {
+        KnxSnapshot snapshot;
+        QVERIFY(snapshot.open(path));
+        snapshot.store(1, 0x0101, frame, sizeof(frame), 0);
+    }
+
+    /* Header count (offset 8) larger than the records in the file */
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    const quint32 count = 0x7FFFFFFF;
+    file.seek(8);
+    file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    file.close();
+
+    KnxSnapshot snapshot;
+    QVERIFY(snapshot.open(path));
+    QCOMPARE(snapshot.size(), 0);
+    QVERIFY(snapshot.record(1) == nullptr);
+}
+
+QTEST_APPLESS_MAIN(TestKnxSnapshot)
+
+#include "tst_knxsnapshot.moc"